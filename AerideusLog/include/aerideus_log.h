@@ -1,6 +1,6 @@
 /*
 	Author: @rasmushugosson
-	Last modified: 2023-03-22
+	Last modified: 2026-10-18
 
 	Aerideus Log is a lightweight and easy to use library for console and file
 	logging. For information about usage and features, please see documentation 
@@ -218,7 +218,10 @@
 
 */
 
+#pragma once
+
 #include <stdio.h>
+#include <stdint.h>
 
 // Severity level -----------------------------------------------------------------------------------------------
 
@@ -253,6 +256,85 @@ void ae_log_file_level_set(log_level min);
 /// <param name="min">is the minimum log_level that will be logged</param>
 #define AE_LOG_FILE_LEVEL_SET(min) ae_log_file_level_set(min)
 
+// Callsite -----------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Internal macro that should not be used
+/// </summary>
+#define I_AE_CALLSITE_PREFIX_SIZE 256
+
+/// <summary>
+/// Internal struct that should not be used. Declared by the logging macros where they are used so that the
+/// start of the line, which never changes for a given line of code, is only rendered the first time. The
+/// filter caches the level and sample rate that the logging configuration sets for the callsite.
+/// </summary>
+typedef struct {
+	const char* file;
+	int line;
+	int level;
+	volatile uint64_t state;
+	volatile uint64_t filter;
+	uint32_t length;
+	char prefix[I_AE_CALLSITE_PREFIX_SIZE];
+} i_ae_callsite;
+
+/// <summary>
+/// Internal function that should only be called through macros. (AE_LOG_CONSOLE_...)
+/// </summary>
+void i_ae_log_console_site(i_ae_callsite* s, log_level l, const char* f, ...);
+
+/// <summary>
+/// Internal function that should only be called through macros. (AE_LOG_FILE_...)
+/// </summary>
+void i_ae_log_file_site(i_ae_callsite* s, log_level l, const char* f, ...);
+
+/// <summary>
+/// Internal macros that should not be used
+/// </summary>
+#define I_AE_CALLSITE_INIT { __FILE__, __LINE__, 0, 0, 0, 0, { 0 } }
+
+/// <summary>
+/// Internal variables that should not be used. The lowest level that a console or file message can have and
+/// still be logged, read by the macros so that the arguments of a filtered message are never evaluated.
+/// </summary>
+extern volatile uint64_t i_ae_log_console_floor;
+extern volatile uint64_t i_ae_log_file_floor;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define I_AE_FLOOR_LOAD(floor) __atomic_load_n(&(floor), __ATOMIC_RELAXED)
+#else
+#define I_AE_FLOOR_LOAD(floor) (floor)
+#endif // __GNUC__ || __clang__
+
+#define I_AE_LOG_CONSOLE(l, f, ...) do { log_level i_ae_level = (l); \
+	if ((uint64_t)i_ae_level >= I_AE_FLOOR_LOAD(i_ae_log_console_floor)) { static i_ae_callsite i_ae_site = I_AE_CALLSITE_INIT; \
+	i_ae_log_console_site(&i_ae_site, i_ae_level, f, ##__VA_ARGS__); } } while (0)
+
+#define I_AE_LOG_FILE(l, f, ...) do { log_level i_ae_level = (l); \
+	if ((uint64_t)i_ae_level >= I_AE_FLOOR_LOAD(i_ae_log_file_floor)) { static i_ae_callsite i_ae_site = I_AE_CALLSITE_INIT; \
+	i_ae_log_file_site(&i_ae_site, i_ae_level, f, ##__VA_ARGS__); } } while (0)
+
+/// <summary>
+/// Internal functions that should only be called through macros. (AE_LOG_..._SAMPLED)
+/// </summary>
+uint32_t i_ae_log_console_sample(i_ae_callsite* s, uint32_t rate);
+uint32_t i_ae_log_file_sample(i_ae_callsite* s, uint32_t rate);
+void i_ae_log_console_sampled(i_ae_callsite* s, uint32_t rate, log_level l, const char* f, ...);
+void i_ae_log_file_sampled(i_ae_callsite* s, uint32_t rate, log_level l, const char* f, ...);
+
+/// <summary>
+/// Internal macros that should not be used. The sampling decision is made before the arguments are evaluated.
+/// </summary>
+#define I_AE_LOG_CONSOLE_SAMPLED(n, l, f, ...) do { log_level i_ae_level = (l); \
+	if ((uint64_t)i_ae_level >= I_AE_FLOOR_LOAD(i_ae_log_console_floor)) { static i_ae_callsite i_ae_site = I_AE_CALLSITE_INIT; \
+	uint32_t i_ae_rate = i_ae_log_console_sample(&i_ae_site, n); \
+	if (i_ae_rate) i_ae_log_console_sampled(&i_ae_site, i_ae_rate, i_ae_level, f, ##__VA_ARGS__); } } while (0)
+
+#define I_AE_LOG_FILE_SAMPLED(n, l, f, ...) do { log_level i_ae_level = (l); \
+	if ((uint64_t)i_ae_level >= I_AE_FLOOR_LOAD(i_ae_log_file_floor)) { static i_ae_callsite i_ae_site = I_AE_CALLSITE_INIT; \
+	uint32_t i_ae_rate = i_ae_log_file_sample(&i_ae_site, n); \
+	if (i_ae_rate) i_ae_log_file_sampled(&i_ae_site, i_ae_rate, i_ae_level, f, ##__VA_ARGS__); } } while (0)
+
 // Console ------------------------------------------------------------------------------------------------------
 
 /// <summary>
@@ -275,42 +357,94 @@ void i_ae_log_console(log_level l, const char* fn, int ln, const char* f, ...);
 /// <param name="l">is the log_level (severity) of the message</param>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE(l, f, ...) i_ae_log_console(l, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE(l, f, ...) I_AE_LOG_CONSOLE(l, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a trace message to the console regardless of build type.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_TRACE(f, ...) i_ae_log_console(TRACE, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_TRACE(f, ...) I_AE_LOG_CONSOLE(TRACE, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an information message to the console regardless of build type.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_INFO(f, ...) i_ae_log_console(INFO, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_INFO(f, ...) I_AE_LOG_CONSOLE(INFO, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a warning to the console regardless of build type.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_WARNING(f, ...) i_ae_log_console(WARNING, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_WARNING(f, ...) I_AE_LOG_CONSOLE(WARNING, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an error to the console regardless of build type.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_ERROR(f, ...) i_ae_log_console(ERROR, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_ERROR(f, ...) I_AE_LOG_CONSOLE(ERROR, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a fatal error to the console regardless of build type.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_FATAL(f, ...) i_ae_log_console(FATAL, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_FATAL(f, ...) I_AE_LOG_CONSOLE(FATAL, f, ##__VA_ARGS__)
+
+// Sampled console ---------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Logs about one in n messages to the console regardless of build type. The line notes
+/// the rate so that counts can be scaled back up.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="l">is the log_level (severity) of the message</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_CONSOLE_SAMPLED(n, l, f, ...) I_AE_LOG_CONSOLE_SAMPLED(n, l, f, ##__VA_ARGS__)
+
+/// <summary>
+/// Logs about one in n trace messages to the console regardless of build type.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_CONSOLE_TRACE_SAMPLED(n, f, ...) I_AE_LOG_CONSOLE_SAMPLED(n, TRACE, f, ##__VA_ARGS__)
+
+/// <summary>
+/// Logs about one in n info messages to the console regardless of build type.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_CONSOLE_INFO_SAMPLED(n, f, ...) I_AE_LOG_CONSOLE_SAMPLED(n, INFO, f, ##__VA_ARGS__)
+
+/// <summary>
+/// Logs about one in n warning messages to the console regardless of build type.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_CONSOLE_WARNING_SAMPLED(n, f, ...) I_AE_LOG_CONSOLE_SAMPLED(n, WARNING, f, ##__VA_ARGS__)
+
+/// <summary>
+/// Logs about one in n error messages to the console regardless of build type.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_CONSOLE_ERROR_SAMPLED(n, f, ...) I_AE_LOG_CONSOLE_SAMPLED(n, ERROR, f, ##__VA_ARGS__)
+
+/// <summary>
+/// Logs about one in n fatal messages to the console regardless of build type.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_CONSOLE_FATAL_SAMPLED(n, f, ...) I_AE_LOG_CONSOLE_SAMPLED(n, FATAL, f, ##__VA_ARGS__)
 
 #ifdef AE_DEBUG
 
@@ -320,42 +454,42 @@ void i_ae_log_console(log_level l, const char* fn, int ln, const char* f, ...);
 /// <param name="l">is the log_level (severity) of the message</param>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DEBUG(l, f, ...) i_ae_log_console(l, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DEBUG(l, f, ...) I_AE_LOG_CONSOLE(l, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a trace message to the console when the build type is Debug.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DEBUG_TRACE(f, ...) i_ae_log_console(TRACE, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DEBUG_TRACE(f, ...) I_AE_LOG_CONSOLE(TRACE, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an information message to the console when the build type is Debug.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DEBUG_INFO(f, ...) i_ae_log_console(INFO, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DEBUG_INFO(f, ...) I_AE_LOG_CONSOLE(INFO, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a warning to the console when the build type is Debug.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DEBUG_WARNING(f, ...) i_ae_log_console(WARNING, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DEBUG_WARNING(f, ...) I_AE_LOG_CONSOLE(WARNING, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an error to the console when the build type is Debug.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DEBUG_ERROR(f, ...) i_ae_log_console(ERROR, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DEBUG_ERROR(f, ...) I_AE_LOG_CONSOLE(ERROR, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a fatal error to the console when the build type is Debug.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DEBUG_FATAL(f, ...) i_ae_log_console(FATAL, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DEBUG_FATAL(f, ...) I_AE_LOG_CONSOLE(FATAL, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a message to the console when the build type is Release. (Removed since build type is currently Debug)
@@ -496,42 +630,42 @@ void i_ae_log_console(log_level l, const char* fn, int ln, const char* f, ...);
 /// <param name="l">is the log_level (severity) of the message</param>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_RELEASE(l, f, ...) i_ae_log_console(l, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_RELEASE(l, f, ...) I_AE_LOG_CONSOLE(l, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a trace message to the console when the build type is Release.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_RELEASE_TRACE(f, ...) i_ae_log_console(TRACE, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_RELEASE_TRACE(f, ...) I_AE_LOG_CONSOLE(TRACE, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an information message to the console when the build type is Release.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_RELEASE_INFO(f, ...) i_ae_log_console(INFO, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_RELEASE_INFO(f, ...) I_AE_LOG_CONSOLE(INFO, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a warning to the console when the build type is Release.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_RELEASE_WARNING(f, ...) i_ae_log_console(WARNING, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_RELEASE_WARNING(f, ...) I_AE_LOG_CONSOLE(WARNING, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an error to the console when the build type is Release.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_RELEASE_ERROR(f, ...) i_ae_log_console(ERROR, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_RELEASE_ERROR(f, ...) I_AE_LOG_CONSOLE(ERROR, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a fatal error to the console when the build type is Release.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_RELEASE_FATAL(f, ...) i_ae_log_console(FATAL, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_RELEASE_FATAL(f, ...) I_AE_LOG_CONSOLE(FATAL, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a message to the console when the build type is Dist. (Removed since build type is currently Release)
@@ -672,42 +806,42 @@ void i_ae_log_console(log_level l, const char* fn, int ln, const char* f, ...);
 /// <param name="l">is the log_level (severity) of the message</param>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DIST(l, f, ...) i_ae_log_console(l, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DIST(l, f, ...) I_AE_LOG_CONSOLE(l, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a trace message to the console when the build type is Dist.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DIST_TRACE(f, ...) i_ae_log_console(TRACE, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DIST_TRACE(f, ...) I_AE_LOG_CONSOLE(TRACE, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an information message to the console when the build type is Dist.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DIST_INFO(f, ...) i_ae_log_console(INFO, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DIST_INFO(f, ...) I_AE_LOG_CONSOLE(INFO, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a warning to the console when the build type is Dist.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DIST_WARNING(f, ...) i_ae_log_console(WARNING, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DIST_WARNING(f, ...) I_AE_LOG_CONSOLE(WARNING, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an error to the console when the build type is Dist.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DIST_ERROR(f, ...) i_ae_log_console(ERROR, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DIST_ERROR(f, ...) I_AE_LOG_CONSOLE(ERROR, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a fatal error to the console when the build type is Dist.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_CONSOLE_DIST_FATAL(f, ...) i_ae_log_console(FATAL, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_CONSOLE_DIST_FATAL(f, ...) I_AE_LOG_CONSOLE(FATAL, f, ##__VA_ARGS__)
 
 #endif // AE_DIST
 
@@ -780,59 +914,146 @@ void i_ae_log_console(log_level l, const char* fn, int ln, const char* f, ...);
 void i_ae_log_file(log_level l, const char* fn, int ln, const char* f, ...);
 
 /// <summary>
-/// Exports the log file to a specified path and frees allocated memory.
+/// Exports the log file to a specified path and frees allocated memory that was not reserved.
 /// </summary>
 /// <param name="p">is the desired path and must end with '.txt'</param>
 void ae_log_file_export(const char* p);
 
 /// <summary>
-/// Exports the log file to a specified path and frees allocated memory.
+/// Allocates memory for the log file up front. No file message allocates memory until the log file is larger
+/// than the reserved size, and the reserved memory is kept and reused when the log file is exported.
+/// </summary>
+/// <param name="size">is the number of bytes to reserve</param>
+/// <returns>1 if the memory was allocated, otherwise 0</returns>
+int ae_log_file_reserve(uint64_t size);
+
+/// <summary>
+/// Exports the log file to a specified path and frees allocated memory that was not reserved.
 /// </summary>
 /// <param name="p">is the desired path and must end with '.txt'</param>
 #define AE_LOG_FILE_EXPORT(p) ae_log_file_export(p)
 
+/// <summary>
+/// Allocates memory for the log file up front so that file messages do not allocate memory.
+/// </summary>
+/// <param name="size">is the number of bytes to reserve</param>
+#define AE_LOG_FILE_RESERVE(size) ae_log_file_reserve(size)
+
+/// <summary>
+/// The format of the lines in the log file.
+/// </summary>
+typedef enum {
+	AE_LOG_FILE_TEXT = 0,
+	AE_LOG_FILE_JSON
+} ae_log_file_format;
+
+/// <summary>
+/// Sets the format of file messages that are logged after the call. With AE_LOG_FILE_JSON every message is a JSON
+/// object on its own line (JSON Lines) with the fields time, level, file, line and message, and blank lines are left out.
+/// </summary>
+/// <param name="format">is the ae_log_file_format to use</param>
+void ae_log_file_format_set(ae_log_file_format format);
+
+/// <summary>
+/// Sets the format of file messages that are logged after the call.
+/// </summary>
+/// <param name="format">is the ae_log_file_format to use</param>
+#define AE_LOG_FILE_FORMAT_SET(format) ae_log_file_format_set(format)
+
 /// <summary>
 /// Logs a message to the log file regardless of build type.
 /// </summary>
 /// <param name="l">is the log_level (severity) of the message</param>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE(l, f, ...) i_ae_log_file(l, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE(l, f, ...) I_AE_LOG_FILE(l, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a trace message to the log file regardless of build type.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_TRACE(f, ...) i_ae_log_file(TRACE, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_TRACE(f, ...) I_AE_LOG_FILE(TRACE, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an information message to the log file regardless of build type.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_INFO(f, ...) i_ae_log_file(INFO, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_INFO(f, ...) I_AE_LOG_FILE(INFO, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a warning to the log file regardless of build type.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_WARNING(f, ...) i_ae_log_file(WARNING, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_WARNING(f, ...) I_AE_LOG_FILE(WARNING, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an error to the log file regardless of build type.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_ERROR(f, ...) i_ae_log_file(ERROR, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_ERROR(f, ...) I_AE_LOG_FILE(ERROR, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a fatal error to the log file regardless of build type.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_FATAL(f, ...) i_ae_log_file(FATAL, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_FATAL(f, ...) I_AE_LOG_FILE(FATAL, f, ##__VA_ARGS__)
+
+// Sampled file ------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Logs about one in n messages to the log file regardless of build type. The line notes
+/// the rate so that counts can be scaled back up.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="l">is the log_level (severity) of the message</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_FILE_SAMPLED(n, l, f, ...) I_AE_LOG_FILE_SAMPLED(n, l, f, ##__VA_ARGS__)
+
+/// <summary>
+/// Logs about one in n trace messages to the log file regardless of build type.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_FILE_TRACE_SAMPLED(n, f, ...) I_AE_LOG_FILE_SAMPLED(n, TRACE, f, ##__VA_ARGS__)
+
+/// <summary>
+/// Logs about one in n info messages to the log file regardless of build type.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_FILE_INFO_SAMPLED(n, f, ...) I_AE_LOG_FILE_SAMPLED(n, INFO, f, ##__VA_ARGS__)
+
+/// <summary>
+/// Logs about one in n warning messages to the log file regardless of build type.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_FILE_WARNING_SAMPLED(n, f, ...) I_AE_LOG_FILE_SAMPLED(n, WARNING, f, ##__VA_ARGS__)
+
+/// <summary>
+/// Logs about one in n error messages to the log file regardless of build type.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_FILE_ERROR_SAMPLED(n, f, ...) I_AE_LOG_FILE_SAMPLED(n, ERROR, f, ##__VA_ARGS__)
+
+/// <summary>
+/// Logs about one in n fatal messages to the log file regardless of build type.
+/// </summary>
+/// <param name="n">is the sample rate, one message in n is logged on average</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_FILE_FATAL_SAMPLED(n, f, ...) I_AE_LOG_FILE_SAMPLED(n, FATAL, f, ##__VA_ARGS__)
 
 #ifdef AE_DEBUG
 
@@ -842,42 +1063,42 @@ void ae_log_file_export(const char* p);
 /// <param name="l">is the log_level (severity) of the message</param>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DEBUG(l, f, ...) i_ae_log_file(l, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DEBUG(l, f, ...) I_AE_LOG_FILE(l, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a trace message to the log file when the build type is Debug.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DEBUG_TRACE(f, ...) i_ae_log_file(TRACE, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DEBUG_TRACE(f, ...) I_AE_LOG_FILE(TRACE, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an information message to the log file when the build type is Debug.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DEBUG_INFO(f, ...) i_ae_log_file(INFO, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DEBUG_INFO(f, ...) I_AE_LOG_FILE(INFO, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a warning to the log file when the build type is Debug.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DEBUG_WARNING(f, ...) i_ae_log_file(WARNING, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DEBUG_WARNING(f, ...) I_AE_LOG_FILE(WARNING, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an error to the log file when the build type is Debug.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DEBUG_ERROR(f, ...) i_ae_log_file(ERROR, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DEBUG_ERROR(f, ...) I_AE_LOG_FILE(ERROR, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a fatal error to the log file when the build type is Debug.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DEBUG_FATAL(f, ...) i_ae_log_file(FATAL, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DEBUG_FATAL(f, ...) I_AE_LOG_FILE(FATAL, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a message to the log file when the build type is Release. (Removed since build type is currently Debug)
@@ -1018,42 +1239,42 @@ void ae_log_file_export(const char* p);
 /// <param name="l">is the log_level (severity) of the message</param>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_RELEASE(l, f, ...) i_ae_log_file(l, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_RELEASE(l, f, ...) I_AE_LOG_FILE(l, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a trace message to the log file when the build type is Release.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_RELEASE_TRACE(f, ...) i_ae_log_file(TRACE, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_RELEASE_TRACE(f, ...) I_AE_LOG_FILE(TRACE, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an information message to the log file when the build type is Release.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_RELEASE_INFO(f, ...) i_ae_log_file(INFO, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_RELEASE_INFO(f, ...) I_AE_LOG_FILE(INFO, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a warning to the log file when the build type is Release.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_RELEASE_WARNING(f, ...) i_ae_log_file(WARNING, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_RELEASE_WARNING(f, ...) I_AE_LOG_FILE(WARNING, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an error to the log file when the build type is Release.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_RELEASE_ERROR(f, ...) i_ae_log_file(ERROR, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_RELEASE_ERROR(f, ...) I_AE_LOG_FILE(ERROR, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a fatal error to the log file when the build type is Release.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_RELEASE_FATAL(f, ...) i_ae_log_file(FATAL, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_RELEASE_FATAL(f, ...) I_AE_LOG_FILE(FATAL, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a message to the log file when the build type is Dist. (Removed since build type is currently Release)
@@ -1194,42 +1415,42 @@ void ae_log_file_export(const char* p);
 /// <param name="l">is the log_level (severity) of the message</param>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DIST(l, f, ...) i_ae_log_file(l, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DIST(l, f, ...) I_AE_LOG_FILE(l, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a trace message to the log file when the build type is Dist.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DIST_TRACE(f, ...) i_ae_log_file(TRACE, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DIST_TRACE(f, ...) I_AE_LOG_FILE(TRACE, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an information message to the log file when the build type is Dist.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DIST_INFO(f, ...) i_ae_log_file(INFO, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DIST_INFO(f, ...) I_AE_LOG_FILE(INFO, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a warning to the log file when the build type is Dist.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DIST_WARNING(f, ...) i_ae_log_file(WARNING, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DIST_WARNING(f, ...) I_AE_LOG_FILE(WARNING, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs an error to the log file when the build type is Dist.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DIST_ERROR(f, ...) i_ae_log_file(ERROR, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DIST_ERROR(f, ...) I_AE_LOG_FILE(ERROR, f, ##__VA_ARGS__)
 
 /// <summary>
 /// Logs a fatal error to the log file when the build type is Dist.
 /// </summary>
 /// <param name="f">is the message format as a const char*</param>
 /// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
-#define AE_LOG_FILE_DIST_FATAL(f, ...) i_ae_log_file(FATAL, I_AE_LOCATION, f, ##__VA_ARGS__)
+#define AE_LOG_FILE_DIST_FATAL(f, ...) I_AE_LOG_FILE(FATAL, f, ##__VA_ARGS__)
 
 #endif // AE_DIST
 
@@ -1293,3 +1514,978 @@ void i_ae_log_file_next_line();
 #define AE_LOG_FILE_NEXT_LINE_DIST() i_ae_log_file_next_line()
 
 #endif // AE_DIST
+
+// Batch --------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Many file messages with the same level that are logged together. A thread has one batch, which is reused.
+/// </summary>
+typedef struct ae_log_batch ae_log_batch;
+
+/// <summary>
+/// Internal functions that should only be called through macros. (AE_LOG_FILE_BATCH_...)
+/// </summary>
+ae_log_batch* i_ae_log_file_batch_begin(i_ae_callsite* s, log_level l, uint32_t count);
+void i_ae_log_file_batch_add(ae_log_batch* b, i_ae_callsite* s, const char* f, ...);
+
+/// <summary>
+/// Logs the messages that have been added to a batch. The messages get the same time and consecutive sequence
+/// numbers, and are handed to the writer thread with one reservation, or written to the log file with one lock,
+/// for every 64 messages. An error batch waits for the disk once. Does nothing if the batch is NULL.
+/// </summary>
+/// <param name="b">is the batch from AE_LOG_FILE_BATCH_BEGIN</param>
+void ae_log_file_batch_commit(ae_log_batch* b);
+
+/// <summary>
+/// Begins a batch of file messages on the calling thread. The level is checked once for the whole batch, and if
+/// it is filtered the batch is set to NULL and the arguments of the messages added to it are never evaluated.
+/// Messages are formatted into a buffer of the thread as they are added and logged by AE_LOG_FILE_BATCH_COMMIT,
+/// which must be called by the same thread. A batch that is still open when the next one begins is committed.
+/// </summary>
+/// <param name="b">is the ae_log_batch* variable to set</param>
+/// <param name="l">is the log_level (severity) of every message in the batch</param>
+/// <param name="count">is the number of messages that are expected, so that space can be made for them once</param>
+#define AE_LOG_FILE_BATCH_BEGIN(b, l, count) do { log_level i_ae_level = (l); (b) = NULL; \
+	if ((uint64_t)i_ae_level >= I_AE_FLOOR_LOAD(i_ae_log_file_floor)) { static i_ae_callsite i_ae_site = I_AE_CALLSITE_INIT; \
+	(b) = i_ae_log_file_batch_begin(&i_ae_site, i_ae_level, count); } } while (0)
+
+/// <summary>
+/// Formats a message into a batch. Does nothing if the batch is NULL.
+/// </summary>
+/// <param name="b">is the batch from AE_LOG_FILE_BATCH_BEGIN</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_FILE_BATCH_ADD(b, f, ...) do { ae_log_batch* i_ae_batch = (b); \
+	if (i_ae_batch) { static i_ae_callsite i_ae_site = I_AE_CALLSITE_INIT; \
+	i_ae_log_file_batch_add(i_ae_batch, &i_ae_site, f, ##__VA_ARGS__); } } while (0)
+
+/// <summary>
+/// Logs the messages that have been added to a batch.
+/// </summary>
+/// <param name="b">is the batch from AE_LOG_FILE_BATCH_BEGIN</param>
+#define AE_LOG_FILE_BATCH_COMMIT(b) ae_log_file_batch_commit(b)
+
+// Hex ----------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Specifies how the bytes of AE_LOG_FILE_HEX messages are written to the log file.
+/// </summary>
+typedef enum {
+	/// <summary>
+	/// The bytes are written as one run of hex digits after the message, so every record stays on one line.
+	/// </summary>
+	AE_LOG_HEX_INLINE = 0,
+
+	/// <summary>
+	/// The bytes are written on the lines after the message in the layout of 'hexdump -C', 16 bytes per line
+	/// with their offset and the printable characters.
+	/// </summary>
+	AE_LOG_HEX_DUMP
+} ae_log_hex_format;
+
+/// <summary>
+/// Internal function that should only be called through macros. (AE_LOG_FILE_HEX)
+/// </summary>
+void i_ae_log_file_hex(i_ae_callsite* s, log_level l, const void* p, uint64_t size, const char* f, ...);
+
+/// <summary>
+/// Internal macro that should not be used
+/// </summary>
+#define I_AE_LOG_FILE_HEX(l, p, size, f, ...) do { log_level i_ae_level = (l); \
+	if ((uint64_t)i_ae_level >= I_AE_FLOOR_LOAD(i_ae_log_file_floor)) { static i_ae_callsite i_ae_site = I_AE_CALLSITE_INIT; \
+	i_ae_log_file_hex(&i_ae_site, i_ae_level, p, size, f, ##__VA_ARGS__); } } while (0)
+
+/// <summary>
+/// Sets how the bytes of AE_LOG_FILE_HEX messages that are written after the call are rendered.
+/// </summary>
+/// <param name="format">is the ae_log_hex_format to use</param>
+void ae_log_file_hex_format_set(ae_log_hex_format format);
+
+/// <summary>
+/// Sets how the bytes of AE_LOG_FILE_HEX messages that are written after the call are rendered.
+/// </summary>
+/// <param name="format">is the ae_log_hex_format to use</param>
+#define AE_LOG_FILE_HEX_FORMAT_SET(format) ae_log_file_hex_format_set(format)
+
+/// <summary>
+/// Logs a message to the log file together with the contents of a buffer, regardless of build type. The bytes
+/// are copied into the record as they are and turned into hex when the record is written to the log file, by
+/// the writer thread if logging is asynchronous. Buffers larger than 1024 bytes are logged as one record per
+/// 1024 bytes, each noting the range of bytes it holds, so nothing is cut. The message is cut to 1023 characters.
+/// </summary>
+/// <param name="l">is the log_level (severity) of the message</param>
+/// <param name="p">is the buffer to log</param>
+/// <param name="size">is the number of bytes to log</param>
+/// <param name="f">is the message format as a const char*</param>
+/// <param name="__VA_ARGS__">is additional arguments to be inserted</param>
+#define AE_LOG_FILE_HEX(l, p, size, f, ...) I_AE_LOG_FILE_HEX(l, p, size, f, ##__VA_ARGS__)
+
+// Shared memory ------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Opens a shared-memory ring named '/[name]-[pid]' that file messages are also written to. The rings of
+/// many processes can be drained and merged into one log by the Collector. Only supported on Linux and MacOS.
+/// </summary>
+/// <param name="name">is the ring name shared by all processes that should be collected together</param>
+/// <param name="slots">is the number of record slots in the ring and must be a power of two</param>
+/// <returns>1 if the ring was opened, otherwise 0</returns>
+int ae_log_shm_open(const char* name, uint32_t slots);
+
+/// <summary>
+/// Unmaps the shared-memory ring. Records that are not yet collected remain in shared memory. Can be called,
+/// like ae_log_shm_open() with a ring already open, while other threads log. It waits until no thread is writing
+/// to the ring before unmapping it.
+/// </summary>
+void ae_log_shm_close(void);
+
+/// <summary>
+/// Opens a shared-memory ring that file messages are also written to.
+/// </summary>
+/// <param name="name">is the ring name shared by all processes that should be collected together</param>
+/// <param name="slots">is the number of record slots in the ring and must be a power of two</param>
+#define AE_LOG_SHM_OPEN(name, slots) ae_log_shm_open(name, slots)
+
+/// <summary>
+/// Unmaps the shared-memory ring.
+/// </summary>
+#define AE_LOG_SHM_CLOSE() ae_log_shm_close()
+
+// Socket -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Specifies how records are sent to a log socket.
+/// </summary>
+typedef enum {
+	/// <summary>
+	/// Records are written as lines and as many as fit are packed into each datagram.
+	/// </summary>
+	AE_LOG_SOCKET_PLAIN = 0,
+
+	/// <summary>
+	/// Records are written as RFC 3164 syslog messages, one per datagram, and sent in batches.
+	/// </summary>
+	AE_LOG_SOCKET_SYSLOG
+} ae_log_socket_format;
+
+/// <summary>
+/// Opens a Unix domain datagram socket that file messages are also sent to, such as '/dev/log' or the
+/// socket of a local log agent. Records are batched and sent without blocking. If the listener is not
+/// available, records are dropped and the connection is retried. A batch that the listener has no room for is
+/// kept and sent again, and only dropped when the next record does not fit. Only supported on Linux and MacOS.
+/// </summary>
+/// <param name="path">is the path of the listening socket</param>
+/// <param name="format">is the ae_log_socket_format that records are sent as</param>
+/// <returns>1 if the socket was opened, otherwise 0</returns>
+int ae_log_socket_open(const char* path, ae_log_socket_format format);
+
+/// <summary>
+/// Sends the records that are currently batched. Batches are otherwise sent when they are full, when an
+/// error is logged or by a flusher thread once their first record has waited for 100 ms.
+/// </summary>
+void ae_log_socket_flush(void);
+
+/// <summary>
+/// Sends the remaining records and closes the log socket. A listener that is behind is given up to 100 ms to
+/// make room for them.
+/// </summary>
+void ae_log_socket_close(void);
+
+/// <summary>
+/// Opens a Unix domain datagram socket that file messages are also sent to.
+/// </summary>
+/// <param name="path">is the path of the listening socket</param>
+/// <param name="format">is the ae_log_socket_format that records are sent as</param>
+#define AE_LOG_SOCKET_OPEN(path, format) ae_log_socket_open(path, format)
+
+/// <summary>
+/// Sends the records that are currently batched.
+/// </summary>
+#define AE_LOG_SOCKET_FLUSH() ae_log_socket_flush()
+
+/// <summary>
+/// Sends the remaining records and closes the log socket.
+/// </summary>
+#define AE_LOG_SOCKET_CLOSE() ae_log_socket_close()
+
+// Thread -------------------------------------------------------------------------------------------------------
+
+// Room for a thread name and its terminating null character, which is the longest name Linux allows
+#define AE_LOG_THREAD_NAME_SIZE 16
+
+/// <summary>
+/// Names the calling thread in the file messages it logs from now on. Every file message carries the id and
+/// name of the thread that logged it, together with a sequence number that counts the messages of the thread
+/// from 0 without gaps. The id and name are read from the operating system once, when the thread logs its
+/// first message, so a thread that is renamed after that must call this function for the new name to be used.
+/// Names longer than AE_LOG_THREAD_NAME_SIZE - 1 bytes are cut.
+/// </summary>
+/// <param name="name">is the name to use, or NULL to read the name from the operating system again</param>
+void ae_log_thread_name_set(const char* name);
+
+/// <summary>
+/// Names the calling thread in the file messages it logs from now on.
+/// </summary>
+/// <param name="name">is the name to use, or NULL to read the name from the operating system again</param>
+#define AE_LOG_THREAD_NAME_SET(name) ae_log_thread_name_set(name)
+
+// Context ------------------------------------------------------------------------------------------------------
+
+// Room for the encoded pairs of a context and all of its parents
+#define AE_LOG_CONTEXT_SIZE 256
+
+/// <summary>
+/// A key-value pair that the file messages of a thread carry while it is the current context, such as a request
+/// id or a tenant. Contexts are declared by the caller, usually on the stack, and are never allocated. The pair is
+/// encoded together with the pairs of its parent when the context is pushed, so every record copies the encoded
+/// bytes as they are and making a context current only swaps a pointer. The data should not be changed directly.
+/// </summary>
+typedef struct ae_log_context {
+	const struct ae_log_context* parent;
+	uint32_t length;
+	char data[AE_LOG_CONTEXT_SIZE];
+} ae_log_context;
+
+/// <summary>
+/// Makes a key-value pair the current context of the calling thread, on top of the current one. The pairs of
+/// every context on the stack are shown before the message as ' | Context: key=value ...' in the text format and
+/// in the records sent to the log socket, and as the fields of a "context" object in the JSON format. A value
+/// longer than fits in AE_LOG_CONTEXT_SIZE together with the pairs below it is cut, and a pair is left out if not
+/// even its key fits. Keys and values are cut to 255 bytes.
+/// </summary>
+/// <param name="c">is the context, which must stay valid until it is popped</param>
+/// <param name="key">is the key, such as "request_id"</param>
+/// <param name="value">is the value, which is copied</param>
+void ae_log_context_push(ae_log_context* c, const char* key, const char* value);
+
+/// <summary>
+/// Makes the parent of a context the current context of the calling thread again. Contexts must be popped in the
+/// reverse order they were pushed.
+/// </summary>
+/// <param name="c">is the context that was pushed last</param>
+void ae_log_context_pop(ae_log_context* c);
+
+/// <summary>
+/// Returns the current context of the calling thread, which is never NULL but may have no pairs.
+/// </summary>
+const ae_log_context* ae_log_context_current(void);
+
+/// <summary>
+/// Makes a context the current context of the calling thread without encoding anything, and returns the context
+/// that was current. Used to hand the context of a request to a worker thread, which swaps the returned context
+/// back when it is done. The context must stay valid for as long as it is current on any thread.
+/// </summary>
+/// <param name="c">is the context to make current, or NULL for none</param>
+/// <returns>the context that was current</returns>
+const ae_log_context* ae_log_context_swap(const ae_log_context* c);
+
+/// <summary>
+/// Declares a context and pushes a key-value pair as the current context of the calling thread.
+/// </summary>
+/// <param name="context">is an identifier for the context, unique within the scope</param>
+/// <param name="key">is the key, such as "request_id"</param>
+/// <param name="value">is the value, which is copied</param>
+#define AE_LOG_CONTEXT_PUSH(context, key, value) \
+	ae_log_context I_AE_CONCAT(i_ae_context_, context); \
+	ae_log_context_push(&I_AE_CONCAT(i_ae_context_, context), key, value)
+
+/// <summary>
+/// Pops a context pushed with AE_LOG_CONTEXT_PUSH().
+/// </summary>
+/// <param name="context">is the identifier of the context</param>
+#define AE_LOG_CONTEXT_POP(context) ae_log_context_pop(&I_AE_CONCAT(i_ae_context_, context))
+
+/// <summary>
+/// Makes a context current on the calling thread and returns the context that was current.
+/// </summary>
+/// <param name="context">is a pointer to the context, or NULL for none</param>
+#define AE_LOG_CONTEXT_SWAP(context) ae_log_context_swap(context)
+
+#if defined(__GNUC__) || defined(__clang__)
+
+/// <summary>
+/// Pushes a key-value pair as the current context for the rest of the enclosing scope. Not available with MSVC,
+/// use AE_LOG_CONTEXT_PUSH() and AE_LOG_CONTEXT_POP().
+/// </summary>
+/// <param name="key">is the key, such as "request_id"</param>
+/// <param name="value">is the value, which is copied</param>
+#define AE_LOG_SCOPE_CONTEXT(key, value) \
+	ae_log_context I_AE_CONCAT(i_ae_context_, __LINE__) __attribute__((cleanup(ae_log_context_pop))); \
+	ae_log_context_push(&I_AE_CONCAT(i_ae_context_, __LINE__), key, value)
+
+#endif // __GNUC__ || __clang__
+
+// Memory -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Specifies which pages back the asynchronous buffers and the reserved log file.
+/// </summary>
+typedef enum {
+	/// <summary>
+	/// Buffers are allocated with malloc.
+	/// </summary>
+	AE_LOG_HUGE_PAGES_OFF = 0,
+
+	/// <summary>
+	/// Buffers are aligned to 2 MB and the kernel is asked to back them with transparent huge pages.
+	/// </summary>
+	AE_LOG_HUGE_PAGES_TRANSPARENT,
+
+	/// <summary>
+	/// Buffers are mapped with MAP_HUGETLB from the huge pages reserved in /proc/sys/vm/nr_hugepages. If
+	/// there are not enough, transparent huge pages are used instead.
+	/// </summary>
+	AE_LOG_HUGE_PAGES_EXPLICIT
+} ae_log_huge_pages;
+
+/// <summary>
+/// Configures how large log buffers are allocated.
+/// </summary>
+typedef struct {
+	/// <summary>
+	/// Which pages back the buffers.
+	/// </summary>
+	ae_log_huge_pages huge_pages;
+
+	/// <summary>
+	/// If not 0, the asynchronous buffer of a thread is moved to the NUMA node of the thread when the thread
+	/// logs its first message.
+	/// </summary>
+	int numa_local;
+} ae_log_memory_config;
+
+/// <summary>
+/// Sets how asynchronous buffers and reserved log file memory are allocated from now on. Buffers that already
+/// exist are not moved, so the policy should be set before ae_log_file_async_start() and ae_log_file_reserve().
+/// Only supported on Linux, other platforms always use malloc.
+/// </summary>
+/// <param name="c">is the ae_log_memory_config to use, or NULL for malloc without NUMA placement</param>
+void ae_log_memory_set(const ae_log_memory_config* c);
+
+/// <summary>
+/// Reads the policy that is in use. If huge pages were asked for but could not be allocated, huge_pages is
+/// what the last buffer got instead.
+/// </summary>
+/// <param name="c">is the ae_log_memory_config to fill in</param>
+void ae_log_memory_get(ae_log_memory_config* c);
+
+/// <summary>
+/// Sets how asynchronous buffers and reserved log file memory are allocated from now on.
+/// </summary>
+/// <param name="c">is the ae_log_memory_config to use, or NULL for malloc without NUMA placement</param>
+#define AE_LOG_MEMORY_SET(c) ae_log_memory_set(c)
+
+/// <summary>
+/// Reads the memory policy that is in use.
+/// </summary>
+/// <param name="c">is the ae_log_memory_config to fill in</param>
+#define AE_LOG_MEMORY_GET(c) ae_log_memory_get(c)
+
+// Async --------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Configures asynchronous file logging. Each logging thread gets its own buffer so that threads never
+/// share memory when logging, and a writer thread merges the buffers in time order.
+/// </summary>
+typedef struct {
+	/// <summary>
+	/// The maximum number of threads with their own buffer (at most 256). Additional threads log synchronously.
+	/// </summary>
+	uint32_t max_threads;
+
+	/// <summary>
+	/// The size of each buffer in bytes, must be a power of two.
+	/// </summary>
+	uint32_t buffer_size;
+
+	/// <summary>
+	/// How long in microseconds the writer holds records back so that records of other threads can be ordered.
+	/// </summary>
+	uint32_t reorder_window;
+
+	/// <summary>
+	/// If 0, a thread waits for space when its buffer is full. Otherwise the message is dropped. Messages in the
+	/// priority lane are never dropped.
+	/// </summary>
+	int drop_when_full;
+
+	/// <summary>
+	/// Messages at or above this level skip the buffers of the threads and are written to a priority lane that
+	/// the writer thread empties first, so that they are not held up by a backlog of less severe messages.
+	/// TRACE turns the lane off.
+	/// </summary>
+	log_level priority_level;
+
+	/// <summary>
+	/// Once the buffer of a thread holds this many bytes, the writer thread writes it as soon as the reorder window
+	/// allows. At most half the buffer size is used.
+	/// </summary>
+	uint32_t flush_size;
+
+	/// <summary>
+	/// How long in microseconds a message can wait in a buffer that is not full before it is written. Values below
+	/// the reorder window are the reorder window.
+	/// </summary>
+	uint32_t flush_latency;
+
+	/// <summary>
+	/// How long in microseconds the writer thread spins, and then yields for as long again, before it parks when
+	/// it has nothing to write. Logging threads only wake the writer when it is parked.
+	/// </summary>
+	uint32_t idle_spin;
+} ae_log_async_config;
+
+/// <summary>
+/// Starts a writer thread that file messages are handed to instead of being written by the logging thread.
+/// </summary>
+/// <param name="c">is the ae_log_async_config to use, or NULL for 64 threads, 1 MB buffers, a 10 ms window, no dropping, a priority lane for errors, a 64 KB flush size, a 20 ms flush latency and a 50 us idle spin</param>
+/// <returns>1 if asynchronous logging was started, otherwise 0</returns>
+int ae_log_file_async_start(const ae_log_async_config* c);
+
+/// <summary>
+/// Writes every buffered message and stops the writer thread. File messages are logged synchronously again.
+/// </summary>
+void ae_log_file_async_stop(void);
+
+/// <summary>
+/// Waits until every file message that was logged before the call has been written.
+/// </summary>
+void ae_log_file_async_flush(void);
+
+/// <summary>
+/// Starts a writer thread that file messages are handed to instead of being written by the logging thread.
+/// </summary>
+/// <param name="c">is the ae_log_async_config to use, or NULL for the defaults</param>
+#define AE_LOG_FILE_ASYNC_START(c) ae_log_file_async_start(c)
+
+/// <summary>
+/// Writes every buffered message and stops the writer thread.
+/// </summary>
+#define AE_LOG_FILE_ASYNC_STOP() ae_log_file_async_stop()
+
+/// <summary>
+/// Waits until every file message that was logged before the call has been written.
+/// </summary>
+#define AE_LOG_FILE_ASYNC_FLUSH() ae_log_file_async_flush()
+
+// Stream -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Specifies when a streamed log file is synced to disk.
+/// </summary>
+typedef enum {
+	/// <summary>
+	/// The log file is written every interval and the operating system decides when it reaches the disk.
+	/// </summary>
+	AE_LOG_FILE_DURABILITY_NONE = 0,
+
+	/// <summary>
+	/// The log file is written and synced every interval. At most one interval of messages can be lost.
+	/// </summary>
+	AE_LOG_FILE_DURABILITY_PERIODIC,
+
+	/// <summary>
+	/// As AE_LOG_FILE_DURABILITY_NONE, but an error or fatal error is on disk before the call that logged it
+	/// returns. Threads that log errors at the same time wait for a single shared sync.
+	/// </summary>
+	AE_LOG_FILE_DURABILITY_GROUP
+} ae_log_file_durability;
+
+/// <summary>
+/// Configures a streamed log file.
+/// </summary>
+typedef struct {
+	/// <summary>
+	/// When the log file is synced to disk.
+	/// </summary>
+	ae_log_file_durability durability;
+
+	/// <summary>
+	/// How often in milliseconds the log file is written, and synced if the durability is periodic.
+	/// </summary>
+	uint32_t interval;
+
+	/// <summary>
+	/// If not 0, the file is written in aligned blocks that bypass the page cache (O_DIRECT on Linux and
+	/// F_NOCACHE on MacOS). If the file system does not support it, the page cache is used.
+	/// </summary>
+	int direct;
+} ae_log_file_stream_config;
+
+/// <summary>
+/// Streams the log file to disk as messages are logged instead of keeping it in memory until it is exported.
+/// Exporting a streamed log file writes and syncs it. Only supported on Linux and MacOS.
+/// </summary>
+/// <param name="path">is the path of the file, which is created or truncated</param>
+/// <param name="c">is the ae_log_file_stream_config to use, or NULL for periodic syncs every second</param>
+/// <returns>1 if the file was opened, otherwise 0</returns>
+int ae_log_file_stream_open(const char* path, const ae_log_file_stream_config* c);
+
+/// <summary>
+/// Writes and syncs everything that has been logged so far.
+/// </summary>
+void ae_log_file_stream_flush(void);
+
+/// <summary>
+/// Writes and syncs the rest of the log file and closes it. The log file is kept in memory again.
+/// </summary>
+void ae_log_file_stream_close(void);
+
+/// <summary>
+/// Streams the log file to disk as messages are logged.
+/// </summary>
+/// <param name="path">is the path of the file, which is created or truncated</param>
+/// <param name="c">is the ae_log_file_stream_config to use, or NULL for periodic syncs every second</param>
+#define AE_LOG_FILE_STREAM_OPEN(path, c) ae_log_file_stream_open(path, c)
+
+/// <summary>
+/// Writes and syncs everything that has been logged so far.
+/// </summary>
+#define AE_LOG_FILE_STREAM_FLUSH() ae_log_file_stream_flush()
+
+/// <summary>
+/// Writes and syncs the rest of the log file and closes it.
+/// </summary>
+#define AE_LOG_FILE_STREAM_CLOSE() ae_log_file_stream_close()
+
+// Subscribe ----------------------------------------------------------------------------------------------------
+
+#define AE_LOG_ENTRY_MESSAGE_SIZE 432
+
+/// <summary>
+/// A file message as it is delivered to a subscriber, or a gap notice if lost is not 0.
+/// </summary>
+typedef struct {
+	/// <summary>
+	/// The position of the record among every record delivered to subscribers. For a gap notice, the
+	/// position of the first record that was lost.
+	/// </summary>
+	uint64_t sequence;
+
+	/// <summary>
+	/// If not 0, the subscriber fell behind and this many records were overwritten before it read them.
+	/// </summary>
+	uint64_t lost;
+
+	/// <summary>
+	/// When the message was logged in nanoseconds since the Unix epoch.
+	/// </summary>
+	uint64_t time;
+
+	/// <summary>
+	/// The file the message was logged from, which is valid for the lifetime of the program.
+	/// </summary>
+	const char* file;
+
+	int line;
+	log_level level;
+
+	/// <summary>
+	/// The length of the message, which is also terminated by a null character.
+	/// </summary>
+	uint32_t length;
+
+	/// <summary>
+	/// If not 0, the message was longer than AE_LOG_ENTRY_MESSAGE_SIZE - 1 characters and was cut.
+	/// </summary>
+	uint32_t truncated;
+
+	/// <summary>
+	/// The id the operating system uses for the thread that logged the message, or 0 for messages that the
+	/// library logs itself, such as the stats report.
+	/// </summary>
+	uint64_t thread;
+
+	/// <summary>
+	/// The position of the message among the messages of its thread, without gaps.
+	/// </summary>
+	uint64_t thread_sequence;
+
+	/// <summary>
+	/// The name of the thread, which is empty if it has none.
+	/// </summary>
+	char thread_name[AE_LOG_THREAD_NAME_SIZE];
+
+	char message[AE_LOG_ENTRY_MESSAGE_SIZE];
+} ae_log_entry;
+
+/// <summary>
+/// The position of a subscriber in the stream of file messages.
+/// </summary>
+typedef struct ae_log_cursor ae_log_cursor;
+
+/// <summary>
+/// Called on the dispatch thread of a subscription for every file message and gap notice.
+/// </summary>
+typedef void (*ae_log_subscriber)(const ae_log_entry* e, void* user);
+
+/// <summary>
+/// Subscribes to file messages that are logged from now on. Messages are kept in a ring of 4096 records
+/// that is shared by every subscriber, and the logging threads never wait for a subscriber. A subscriber
+/// that falls more than the size of the ring behind receives a gap notice and continues with the oldest
+/// message that is left.
+/// </summary>
+/// <returns>a cursor that must be given to ae_log_unsubscribe(), or NULL if memory could not be allocated</returns>
+ae_log_cursor* ae_log_subscribe(void);
+
+/// <summary>
+/// Subscribes to file messages with a callback that is called on a dispatch thread of its own, so that a slow
+/// callback only delays itself.
+/// </summary>
+/// <param name="fn">is the ae_log_subscriber that is called for every message and gap notice</param>
+/// <param name="user">is passed to the callback</param>
+/// <returns>a cursor that must be given to ae_log_unsubscribe(), or NULL if the subscription failed</returns>
+ae_log_cursor* ae_log_subscribe_callback(ae_log_subscriber fn, void* user);
+
+/// <summary>
+/// Reads the next message of a cursor from ae_log_subscribe(). A cursor must only be read by one thread at a time.
+/// </summary>
+/// <param name="c">is the cursor to read from</param>
+/// <param name="e">is filled in with the message or a gap notice</param>
+/// <returns>1 if an entry was read, or 0 if there is no new message</returns>
+int ae_log_cursor_poll(ae_log_cursor* c, ae_log_entry* e);
+
+/// <summary>
+/// Ends a subscription. A callback subscription waits for the callback that is running to return.
+/// </summary>
+void ae_log_unsubscribe(ae_log_cursor* c);
+
+/// <summary>
+/// Subscribes to file messages that are logged from now on.
+/// </summary>
+#define AE_LOG_SUBSCRIBE() ae_log_subscribe()
+
+/// <summary>
+/// Subscribes to file messages with a callback that is called on a dispatch thread of its own.
+/// </summary>
+/// <param name="fn">is the ae_log_subscriber that is called for every message and gap notice</param>
+/// <param name="user">is passed to the callback</param>
+#define AE_LOG_SUBSCRIBE_CALLBACK(fn, user) ae_log_subscribe_callback(fn, user)
+
+/// <summary>
+/// Reads the next message of a cursor, returns 1 if an entry was read.
+/// </summary>
+/// <param name="c">is the cursor to read from</param>
+/// <param name="e">is filled in with the message or a gap notice</param>
+#define AE_LOG_CURSOR_POLL(c, e) ae_log_cursor_poll(c, e)
+
+/// <summary>
+/// Ends a subscription.
+/// </summary>
+#define AE_LOG_UNSUBSCRIBE(c) ae_log_unsubscribe(c)
+
+// Stats --------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// What the logger itself has cost so far. The counters are kept per thread and summed when they are read.
+/// </summary>
+typedef struct {
+	/// <summary>
+	/// The number of console and file messages per log_level.
+	/// </summary>
+	uint64_t console_records[5];
+	uint64_t file_records[5];
+
+	/// <summary>
+	/// The number of bytes added to the log file.
+	/// </summary>
+	uint64_t bytes;
+
+	/// <summary>
+	/// The number of messages that were dropped by a full buffer, shared-memory ring or socket.
+	/// </summary>
+	uint64_t dropped;
+
+	/// <summary>
+	/// The part of dropped that the socket dropped, because its listener was unavailable or could not keep up.
+	/// </summary>
+	uint64_t socket_dropped;
+
+	/// <summary>
+	/// The number of file messages that were lost because memory could not be allocated.
+	/// </summary>
+	uint64_t allocation_failures;
+
+	/// <summary>
+	/// The number of bytes waiting for the asynchronous writer thread.
+	/// </summary>
+	uint64_t queue_depth;
+
+	/// <summary>
+	/// The number of timed file calls, the total time in nanoseconds they took and how much of it was spent
+	/// formatting. See ae_log_stats_sample_set().
+	/// </summary>
+	uint64_t sampled_calls;
+	uint64_t sampled_call_time;
+	uint64_t sampled_format_time;
+
+	/// <summary>
+	/// The longest timed file call in nanoseconds.
+	/// </summary>
+	uint64_t max_call_time;
+
+	/// <summary>
+	/// The number of exports and the total time in nanoseconds they took.
+	/// </summary>
+	uint64_t exports;
+	uint64_t export_time;
+} ae_log_stats;
+
+/// <summary>
+/// Reads the stats of every thread.
+/// </summary>
+/// <param name="s">is the ae_log_stats to fill in</param>
+void ae_log_stats_get(ae_log_stats* s);
+
+/// <summary>
+/// Times every n:th file call of each thread. Timing is disabled by default.
+/// </summary>
+/// <param name="n">is how often to time a call, or 0 to disable timing</param>
+void ae_log_stats_sample_set(uint32_t n);
+
+/// <summary>
+/// Adds a stats message to the log file at most once per interval. The report is disabled by default.
+/// </summary>
+/// <param name="interval">is the interval in milliseconds, or 0 to disable the report</param>
+void ae_log_stats_report_set(uint32_t interval);
+
+/// <summary>
+/// Reads the stats of every thread.
+/// </summary>
+/// <param name="s">is the ae_log_stats to fill in</param>
+#define AE_LOG_STATS_GET(s) ae_log_stats_get(s)
+
+/// <summary>
+/// Times every n:th file call of each thread, or no calls if n is 0.
+/// </summary>
+#define AE_LOG_STATS_SAMPLE_SET(n) ae_log_stats_sample_set(n)
+
+/// <summary>
+/// Adds a stats message to the log file at most once per interval in milliseconds, or never if it is 0.
+/// </summary>
+#define AE_LOG_STATS_REPORT_SET(interval) ae_log_stats_report_set(interval)
+
+// Timer --------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Internal macro that should not be used
+/// </summary>
+#define I_AE_TIMER_BUCKETS 976
+
+/// <summary>
+/// Internal struct that should not be used. A histogram of one timer, declared where the timer is used.
+/// </summary>
+typedef struct i_ae_timer_site {
+	const char* name;
+	const char* file;
+	int line;
+	volatile uint64_t registered;
+	volatile uint64_t max;
+	struct i_ae_timer_site* next;
+	volatile uint64_t buckets[I_AE_TIMER_BUCKETS];
+} i_ae_timer_site;
+
+/// <summary>
+/// Internal struct that should not be used
+/// </summary>
+typedef struct {
+	i_ae_timer_site* site;
+	uint64_t start;
+} i_ae_timer_scope;
+
+/// <summary>
+/// Internal function that should only be called through macros. (AE_LOG_..._TIMER...)
+/// </summary>
+uint64_t i_ae_timer_ticks(void);
+
+/// <summary>
+/// Internal function that should only be called through macros. (AE_LOG_..._TIMER...)
+/// </summary>
+/// <param name="s">should not be specified</param>
+void i_ae_timer_end(i_ae_timer_scope* s);
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define I_AE_TIMER_TICKS() __rdtsc()
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define I_AE_TIMER_TICKS() __builtin_ia32_rdtsc()
+#else
+#define I_AE_TIMER_TICKS() i_ae_timer_ticks()
+#endif // _MSC_VER
+
+/// <summary>
+/// Internal macros that should not be used
+/// </summary>
+#define I_AE_CONCAT_INNER(a, b) a##b
+#define I_AE_CONCAT(a, b) I_AE_CONCAT_INNER(a, b)
+
+/// <summary>
+/// Writes the percentiles of every timer to the log file and starts new histograms. Called automatically when
+/// the log file is exported. Nothing is written or reset while the file level filters out INFO messages.
+/// </summary>
+void ae_log_timer_dump(void);
+
+/// <summary>
+/// Dumps the timers at most once per interval. Checked when a timer ends. Disabled by default.
+/// </summary>
+/// <param name="interval">is the interval in milliseconds, or 0 to only dump on export</param>
+void ae_log_timer_report_set(uint32_t interval);
+
+/// <summary>
+/// Starts a named timer. Only the elapsed time is recorded when it ends, the histogram is formatted when the
+/// timers are dumped.
+/// </summary>
+/// <param name="timer">is an identifier for the timer, unique within the scope</param>
+/// <param name="name">is the name of the timer as a string literal</param>
+#define AE_LOG_TIMER_BEGIN(timer, name) \
+	static i_ae_timer_site I_AE_CONCAT(i_ae_timer_site_, timer) = { name, I_AE_LOCATION, 0, 0, NULL, { 0 } }; \
+	i_ae_timer_scope I_AE_CONCAT(i_ae_timer_scope_, timer) = { &I_AE_CONCAT(i_ae_timer_site_, timer), I_AE_TIMER_TICKS() }
+
+/// <summary>
+/// Ends a timer started with AE_LOG_TIMER_BEGIN() and records the elapsed time.
+/// </summary>
+/// <param name="timer">is the identifier of the timer</param>
+#define AE_LOG_TIMER_END(timer) i_ae_timer_end(&I_AE_CONCAT(i_ae_timer_scope_, timer))
+
+#if defined(__GNUC__) || defined(__clang__)
+
+/// <summary>
+/// Times the rest of the enclosing scope. Not available with MSVC, use AE_LOG_TIMER_BEGIN() and AE_LOG_TIMER_END().
+/// </summary>
+/// <param name="name">is the name of the timer as a string literal</param>
+#define AE_LOG_SCOPE_TIMER(name) \
+	static i_ae_timer_site I_AE_CONCAT(i_ae_timer_site_, __LINE__) = { name, I_AE_LOCATION, 0, 0, NULL, { 0 } }; \
+	i_ae_timer_scope I_AE_CONCAT(i_ae_timer_scope_, __LINE__) __attribute__((cleanup(i_ae_timer_end))) = \
+		{ &I_AE_CONCAT(i_ae_timer_site_, __LINE__), I_AE_TIMER_TICKS() }
+
+#endif // __GNUC__ || __clang__
+
+/// <summary>
+/// Writes the percentiles of every timer to the log file and starts new histograms.
+/// </summary>
+#define AE_LOG_TIMER_DUMP() ae_log_timer_dump()
+
+/// <summary>
+/// Dumps the timers at most once per interval in milliseconds, or only on export if it is 0.
+/// </summary>
+#define AE_LOG_TIMER_REPORT_SET(interval) ae_log_timer_report_set(interval)
+
+// Trace --------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Internal struct that should not be used
+/// </summary>
+typedef struct {
+	const char* name;
+	uint64_t start;
+} i_ae_trace_span;
+
+/// <summary>
+/// Internal functions that should only be called through macros. (AE_LOG_SPAN_... and AE_LOG_TRACE_...)
+/// </summary>
+uint64_t i_ae_trace_span_begin(void);
+void i_ae_trace_span_end(i_ae_trace_span* s);
+void i_ae_trace_event(char type, const char* name);
+
+/// <summary>
+/// Opens a Chrome trace-event file that spans, instant events and file messages are written to. The events
+/// of each thread are buffered and only written when the trace is flushed.
+/// </summary>
+/// <param name="path">is the path of the JSON file to create</param>
+/// <returns>1 if the file was created, otherwise 0</returns>
+int ae_log_trace_open(const char* path);
+
+/// <summary>
+/// Writes every buffered event to the trace file. Called automatically when the log file is exported.
+/// </summary>
+void ae_log_trace_flush(void);
+
+/// <summary>
+/// Writes every buffered event and closes the trace file so that it can be loaded.
+/// </summary>
+void ae_log_trace_close(void);
+
+/// <summary>
+/// Opens a Chrome trace-event file that spans, instant events and file messages are written to.
+/// </summary>
+/// <param name="path">is the path of the JSON file to create</param>
+#define AE_LOG_TRACE_OPEN(path) ae_log_trace_open(path)
+
+/// <summary>
+/// Writes every buffered event to the trace file.
+/// </summary>
+#define AE_LOG_TRACE_FLUSH() ae_log_trace_flush()
+
+/// <summary>
+/// Writes every buffered event and closes the trace file.
+/// </summary>
+#define AE_LOG_TRACE_CLOSE() ae_log_trace_close()
+
+/// <summary>
+/// Begins a span on the track of the calling thread. Must be ended by the same thread.
+/// </summary>
+/// <param name="name">is the name of the span as a string literal</param>
+#define AE_LOG_SPAN_BEGIN(name) i_ae_trace_event('B', name)
+
+/// <summary>
+/// Ends the last span that the calling thread began.
+/// </summary>
+/// <param name="name">is the name of the span as a string literal</param>
+#define AE_LOG_SPAN_END(name) i_ae_trace_event('E', name)
+
+/// <summary>
+/// Marks a point in time on the track of the calling thread.
+/// </summary>
+/// <param name="name">is the name of the event as a string literal</param>
+#define AE_LOG_TRACE_INSTANT(name) i_ae_trace_event('I', name)
+
+#if defined(__GNUC__) || defined(__clang__)
+
+/// <summary>
+/// Adds the rest of the enclosing scope as a span. Not available with MSVC, use AE_LOG_SPAN_BEGIN() and AE_LOG_SPAN_END().
+/// </summary>
+/// <param name="name">is the name of the span as a string literal</param>
+#define AE_LOG_SCOPE_SPAN(name) \
+	i_ae_trace_span I_AE_CONCAT(i_ae_trace_span_, __LINE__) __attribute__((cleanup(i_ae_trace_span_end))) = \
+		{ name, i_ae_trace_span_begin() }
+
+#endif // __GNUC__ || __clang__
+
+// Config -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Loads a logging configuration file and applies it. Each line is a 'key = value' setting and lines starting
+/// with '#' are comments, see README.md for the available settings. If any line is invalid, nothing is applied.
+/// </summary>
+/// <param name="path">is the path of the configuration file, or NULL to use the AE_LOG_CONFIG environment variable</param>
+/// <returns>1 if the configuration was applied, otherwise 0</returns>
+int ae_log_config_load(const char* path);
+
+/// <summary>
+/// Loads a logging configuration file and starts a thread that applies it again whenever the file changes.
+/// Changes are applied while other threads keep logging without waiting for them.
+/// </summary>
+/// <param name="path">is the path of the configuration file, or NULL to use the AE_LOG_CONFIG environment variable</param>
+/// <returns>1 if the configuration was applied and is being watched, otherwise 0</returns>
+int ae_log_config_watch(const char* path);
+
+/// <summary>
+/// Stops watching the configuration file. The last applied configuration remains in effect.
+/// </summary>
+void ae_log_config_unwatch(void);
+
+/// <summary>
+/// Loads a logging configuration file and applies it.
+/// </summary>
+/// <param name="path">is the path of the configuration file, or NULL to use the AE_LOG_CONFIG environment variable</param>
+#define AE_LOG_CONFIG_LOAD(path) ae_log_config_load(path)
+
+/// <summary>
+/// Loads a logging configuration file and applies it again whenever the file changes.
+/// </summary>
+/// <param name="path">is the path of the configuration file, or NULL to use the AE_LOG_CONFIG environment variable</param>
+#define AE_LOG_CONFIG_WATCH(path) ae_log_config_watch(path)
+
+/// <summary>
+/// Stops watching the configuration file.
+/// </summary>
+#define AE_LOG_CONFIG_UNWATCH() ae_log_config_unwatch()
@@ -0,0 +1,355 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+
+	Internal functions shared between the translation units of Aerideus Log. Nothing
+	in this file is part of the public interface.
+*/
+
+#pragma once
+
+#include "../include/aerideus_log.h"
+
+#include <stdint.h>
+#include <stdarg.h>
+
+#define AE_LOG_FILE_BUFFER_SIZE 1024
+
+// Record -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// A formatted file message on its way to the sinks. A record without a file is a blank line. The site is
+/// set if the start of the line has been rendered for the line of code that logged the record. The rate is
+/// above 1 if only one in that many messages from the line of code are logged. The thread is 0 for records
+/// that the library writes itself, such as the stats report. A record from AE_LOG_FILE_HEX carries a chunk of
+/// bytes that starts at the offset in a blob of the size, which is rendered after the message in the log file.
+/// The context is the encoded pairs of the context of the thread when the record was logged.
+/// </summary>
+typedef struct
+{
+	log_level level;
+	int line;
+	const char* file;
+	uint64_t time;
+	uint64_t sequence;
+	uint64_t thread;
+	const char* thread_name;
+	const char* message;
+	uint64_t length;
+	const i_ae_callsite* site;
+	uint32_t rate;
+	const unsigned char* data;
+	uint64_t data_length;
+	uint64_t data_offset;
+	uint64_t data_size;
+	const char* context;
+	uint64_t context_length;
+} ae_record;
+
+// Callsite -----------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Renders '[LEVEL] file | Line: N | Message: '' after a color sequence and returns its length.
+/// </summary>
+uint64_t i_ae_callsite_render(char* out, uint64_t size, const char* color, log_level l, const char* fn, int ln);
+
+/// <summary>
+/// Returns the callsite with its prefix rendered, rendering it on the first call. Returns NULL if the prefix
+/// can not be used and must instead be rendered with i_ae_callsite_render().
+/// </summary>
+const i_ae_callsite* i_ae_callsite_prefix(i_ae_callsite* s, log_level l, const char* color);
+
+/// <summary>
+/// Returns 1 with a probability of one in the rate, using a random generator of the calling thread.
+/// </summary>
+int i_ae_callsite_hit(uint32_t rate);
+
+// Thread -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// The identity of a logging thread, which is read from the operating system once and kept in thread local
+/// storage so that records can carry it for the cost of a copy. The sequence is that of the next record. The
+/// context is the current context of the thread and is never NULL.
+/// </summary>
+typedef struct
+{
+	uint64_t id;
+	uint64_t sequence;
+	char name[AE_LOG_THREAD_NAME_SIZE];
+	const ae_log_context* context;
+} i_ae_thread_info;
+
+/// <summary>
+/// Returns the identity of the calling thread, reading it on the first call from the thread.
+/// </summary>
+i_ae_thread_info* i_ae_thread_info_get(void);
+
+// Context ------------------------------------------------------------------------------------------------------
+
+// The longest context rendered by i_ae_context_text() and i_ae_context_json()
+#define I_AE_CONTEXT_TEXT_SIZE (AE_LOG_CONTEXT_SIZE + 16)
+#define I_AE_CONTEXT_JSON_SIZE (AE_LOG_CONTEXT_SIZE * 6 + 16)
+
+/// <summary>
+/// The context of a thread that has not pushed one, which has no pairs.
+/// </summary>
+extern const ae_log_context i_ae_context_none;
+
+/// <summary>
+/// Renders encoded context pairs as ' | Context: key=value ...' and returns the length, or 0 if there are none.
+/// </summary>
+uint64_t i_ae_context_text(char* out, const char* context, uint64_t length);
+
+/// <summary>
+/// Renders encoded context pairs as ',"context":{"key":"value",...}' and returns the length, or 0 if there are none.
+/// </summary>
+uint64_t i_ae_context_json(char* out, const char* context, uint64_t length);
+
+// Config -------------------------------------------------------------------------------------------------------
+
+enum
+{
+	AE_CONFIG_CONSOLE = 0, AE_CONFIG_FILE
+};
+
+/// <summary>
+/// Returns the minimum level for messages from a callsite, which is the level of the last filter of the sink
+/// that matches its file or otherwise the level of the sink. The match is cached in the callsite until the
+/// configuration changes.
+/// </summary>
+log_level i_ae_config_level(i_ae_callsite* s, int sink, log_level level);
+
+/// <summary>
+/// Returns the sample rate for messages from a callsite, which is the rate of the last sampling filter of the
+/// sink that matches it or otherwise the rate specified where the message is logged.
+/// </summary>
+uint32_t i_ae_config_rate(i_ae_callsite* s, int sink, uint32_t rate);
+
+/// <summary>
+/// Returns the lowest of a level and the levels of the filters of a sink.
+/// </summary>
+log_level i_ae_config_floor(int sink, log_level level);
+
+// Levels -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Recomputes the lowest level that can be logged to the console or file after the level or filters changed.
+/// </summary>
+void i_ae_log_console_floor_update(void);
+void i_ae_log_file_floor_update(void);
+
+// File ---------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Part of the in-memory log file. Pooled chunks hold AE_LOG_FILE_CHUNK_SIZE bytes, a message that is too long
+/// for the message buffer is formatted into a chunk of its own with the exact size, which is not pooled.
+/// </summary>
+typedef struct ae_file_chunk
+{
+	struct ae_file_chunk* next;
+	uint64_t size;
+	uint64_t capacity;
+	uint64_t pooled;
+	char data[];
+} ae_file_chunk;
+
+/// <summary>
+/// Writes a record to the log file and the socket. Called by the logging thread when logging is
+/// synchronous and by the writer thread when it is asynchronous.
+/// </summary>
+void i_ae_log_file_emit(const ae_record* r);
+
+/// <summary>
+/// Logs formatted records that belong together. They are handed to the writer thread with one reservation if it
+/// is running, and otherwise written to the log file with the same time while the lock is held once.
+/// </summary>
+void i_ae_log_file_write_records(ae_record* r, uint32_t count);
+
+/// <summary>
+/// Returns 1 if a file message with the specified level from a callsite passes the file level and the configuration.
+/// Without a callsite only the file level is checked, like i_ae_log_file() does.
+/// </summary>
+int i_ae_log_file_enabled(i_ae_callsite* s, log_level l);
+
+/// <summary>
+/// Removes everything from the in-memory log file and returns it as a list of chunks, which must be given back
+/// with i_ae_log_file_release(). The end is set to the number of bytes added to the log file so far.
+/// </summary>
+ae_file_chunk* i_ae_log_file_detach(uint64_t* end);
+
+/// <summary>
+/// Gives back chunks from i_ae_log_file_detach() so that their memory can be reused.
+/// </summary>
+void i_ae_log_file_release(ae_file_chunk* c);
+
+/// <summary>
+/// Returns the number of bytes added to the log file so far, including bytes that have been detached.
+/// </summary>
+uint64_t i_ae_log_file_end(void);
+
+// Stream -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Waits until everything logged so far is on disk if the record is an error or fatal error and the log file
+/// is streamed with group commit. Threads that wait at the same time share a single sync.
+/// </summary>
+void i_ae_log_stream_commit(log_level l);
+
+/// <summary>
+/// Writes and syncs a streamed log file when it is exported. Returns 0 if the log file is not streamed.
+/// </summary>
+int i_ae_log_stream_export(void);
+
+// JSON ---------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Escapes a string for use inside a JSON string and returns the number of bytes written. The output must have
+/// room for 6 bytes per input byte.
+/// </summary>
+uint64_t i_ae_json_escape(char* out, const char* in, uint64_t len);
+
+// Hex ----------------------------------------------------------------------------------------------------------
+
+// Blobs are logged as one record per this many bytes
+#define AE_LOG_HEX_CHUNK_SIZE 1024
+
+/// <summary>
+/// Writes two lowercase hex digits for every byte and returns the number of characters written.
+/// </summary>
+uint64_t i_ae_hex_encode(char* out, const unsigned char* in, uint64_t len);
+
+/// <summary>
+/// Writes bytes in the layout of 'hexdump -C', 16 per line with their address and the printable characters,
+/// and returns the number of characters written. The lines are separated, but not ended, by a line break.
+/// </summary>
+uint64_t i_ae_hex_dump(char* out, const unsigned char* in, uint64_t len, uint64_t offset);
+
+// Async --------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Formats a record into the buffer of the calling thread if the asynchronous writer is running.
+/// Returns 0 if the record must instead be emitted synchronously.
+/// </summary>
+int i_ae_async_write(ae_record* r, const char* f, va_list args);
+
+/// <summary>
+/// Copies formatted records into the buffer of the calling thread if the asynchronous writer is running, with
+/// one reservation per quarter of the buffer. Returns how many records, counted from the first, were taken. The
+/// rest, which is only left if the buffer is full and records are not dropped, a record is too long for the
+/// buffer or the writer stopped, must be emitted synchronously.
+/// </summary>
+uint32_t i_ae_async_write_records(ae_record* r, uint32_t count);
+
+/// <summary>
+/// Waits until the writer thread has emitted every record that was logged before the call.
+/// </summary>
+void i_ae_async_flush(void);
+
+/// <summary>
+/// Waits until the writer thread has emitted every record of the level that was logged before the call. For a
+/// level in the priority lane only the lane is waited for, otherwise every record.
+/// </summary>
+void i_ae_async_flush_level(log_level l);
+
+/// <summary>
+/// Returns the number of bytes that are buffered for the writer thread.
+/// </summary>
+uint64_t i_ae_async_depth(void);
+
+// Shared memory ------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Publishes a record to the shared-memory ring if one is open.
+/// </summary>
+void i_ae_log_shm_write(const ae_record* r);
+
+// Trace --------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Adds a record to the trace buffer of the calling thread if a trace is open.
+/// </summary>
+void i_ae_log_trace_write(const ae_record* r);
+
+// Socket -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Adds a record to the batch of the log socket if one is open.
+/// </summary>
+void i_ae_log_socket_write(const ae_record* r);
+
+// Memory -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// How a buffer from i_ae_memory_alloc() was allocated, which is needed to free it.
+/// </summary>
+enum
+{
+	AE_MEMORY_HEAP = 0, AE_MEMORY_MAPPED, AE_MEMORY_HUGE
+};
+
+/// <summary>
+/// Allocates a large buffer with the policy of ae_log_memory_set(). The memory is not touched.
+/// </summary>
+void* i_ae_memory_alloc(uint64_t size, int* kind);
+
+/// <summary>
+/// Frees a buffer from i_ae_memory_alloc() with the size and kind it was allocated with.
+/// </summary>
+void i_ae_memory_free(void* p, uint64_t size, int kind);
+
+/// <summary>
+/// Moves a buffer from i_ae_memory_alloc() to the NUMA node of the calling thread if NUMA placement is on.
+/// </summary>
+void i_ae_memory_place(void* p, uint64_t size, int kind);
+
+// Subscribe ----------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Copies a record into the ring that subscribers read from if there are any. Must be called with the log
+/// file lock held since records are written by one thread at a time.
+/// </summary>
+void i_ae_log_subscribe_write(const ae_record* r);
+
+// Stats --------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Counters kept per thread and summed by ae_log_stats_get(). The console and file counters are indexed
+/// by log_level.
+/// </summary>
+enum
+{
+	AE_STATS_CONSOLE = 0,
+	AE_STATS_FILE = 5,
+	AE_STATS_BYTES = 10,
+	AE_STATS_DROPPED,
+	AE_STATS_SOCKET_DROPPED,
+	AE_STATS_ALLOCATION_FAILURES,
+	AE_STATS_SAMPLED_CALLS,
+	AE_STATS_CALL_TIME,
+	AE_STATS_FORMAT_TIME,
+	AE_STATS_CALL_TIME_MAX,
+	AE_STATS_EXPORTS,
+	AE_STATS_EXPORT_TIME,
+	AE_STATS_COUNT
+};
+
+/// <summary>
+/// Adds to a counter of the calling thread.
+/// </summary>
+void i_ae_stats_add(uint32_t counter, uint64_t v);
+
+/// <summary>
+/// Raises a counter of the calling thread to the specified value if it is lower.
+/// </summary>
+void i_ae_stats_max(uint32_t counter, uint64_t v);
+
+/// <summary>
+/// Returns 1 if the current call should be timed according to the sample rate.
+/// </summary>
+int i_ae_stats_sample(void);
+
+/// <summary>
+/// Renders the periodic self-report into the buffer if it is due at the specified time. Returns the length
+/// of the report, or 0 if no report is due. Must be called with the file lock held.
+/// </summary>
+uint64_t i_ae_stats_report(uint64_t time, char* buffer, uint64_t size);
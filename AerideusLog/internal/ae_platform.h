@@ -0,0 +1,377 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+
+	Internal platform layer for Aerideus Log. Wraps the few compiler and operating
+	system specifics that the library needs (bounds-checked CRT functions, atomics
+	time and threads) so that the rest of the source can stay platform independent.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <time.h>
+
+#ifdef AE_WINDOWS
+
+#include <Windows.h>
+#include <intrin.h>
+#include <process.h>
+
+// Windows.h defines ERROR which would otherwise replace the log_level of the same name
+#undef ERROR
+
+#else
+
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+
+#ifdef AE_LINUX
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif // AE_LINUX
+
+#endif // AE_WINDOWS
+
+// CRT ----------------------------------------------------------------------------------------------------------
+
+#ifndef AE_WINDOWS
+
+#define sprintf_s snprintf
+#define vsnprintf_s(b, s, c, f, a) vsnprintf(b, s, f, a)
+#define fprintf_s fprintf
+#define fopen_s(pf, p, m) ((*(pf) = fopen(p, m)) ? 0 : errno)
+#define gmtime_s(t, s) gmtime_r(s, t)
+
+#endif // AE_WINDOWS
+
+// Compiler -----------------------------------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+
+#define AE_THREAD_LOCAL __declspec(thread)
+#define AE_ALIGN(n) __declspec(align(n))
+
+#else
+
+#define AE_THREAD_LOCAL __thread
+#define AE_ALIGN(n) __attribute__((aligned(n)))
+
+#endif // _MSC_VER
+
+#define AE_CACHE_LINE 64
+
+// Atomics ------------------------------------------------------------------------------------------------------
+
+#ifdef AE_WINDOWS
+
+static inline uint64_t i_ae_atomic_load(volatile uint64_t* p)
+{
+	return (uint64_t)_InterlockedCompareExchange64((volatile long long*)p, 0, 0);
+}
+
+static inline void i_ae_atomic_store(volatile uint64_t* p, uint64_t v)
+{
+	_InterlockedExchange64((volatile long long*)p, (long long)v);
+}
+
+static inline uint64_t i_ae_atomic_add(volatile uint64_t* p, uint64_t v)
+{
+	return (uint64_t)_InterlockedExchangeAdd64((volatile long long*)p, (long long)v);
+}
+
+/// <summary>
+/// Adds to a value with a full barrier, later loads can not be reordered before the add.
+/// </summary>
+static inline uint64_t i_ae_atomic_add_full(volatile uint64_t* p, uint64_t v)
+{
+	return (uint64_t)_InterlockedExchangeAdd64((volatile long long*)p, (long long)v);
+}
+
+static inline int i_ae_atomic_cas(volatile uint64_t* p, uint64_t expected, uint64_t desired)
+{
+	return (uint64_t)_InterlockedCompareExchange64((volatile long long*)p, (long long)desired, (long long)expected) == expected;
+}
+
+/// <summary>
+/// Stores a value with a full barrier, later loads can not be reordered before the store.
+/// </summary>
+static inline uint64_t i_ae_atomic_exchange(volatile uint64_t* p, uint64_t v)
+{
+	return (uint64_t)_InterlockedExchange64((volatile long long*)p, (long long)v);
+}
+
+/// <summary>
+/// Loads a value without ordering, for counters that are only written by one thread.
+/// </summary>
+static inline uint64_t i_ae_atomic_load_relaxed(volatile uint64_t* p)
+{
+	return *p;
+}
+
+/// <summary>
+/// Stores a value without ordering, for counters that are only written by one thread.
+/// </summary>
+static inline void i_ae_atomic_store_relaxed(volatile uint64_t* p, uint64_t v)
+{
+	*p = v;
+}
+
+#else
+
+static inline uint64_t i_ae_atomic_load(volatile uint64_t* p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void i_ae_atomic_store(volatile uint64_t* p, uint64_t v)
+{
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline uint64_t i_ae_atomic_add(volatile uint64_t* p, uint64_t v)
+{
+	return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+}
+
+/// <summary>
+/// Adds to a value with a full barrier, later loads can not be reordered before the add.
+/// </summary>
+static inline uint64_t i_ae_atomic_add_full(volatile uint64_t* p, uint64_t v)
+{
+	return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST);
+}
+
+static inline int i_ae_atomic_cas(volatile uint64_t* p, uint64_t expected, uint64_t desired)
+{
+	return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/// <summary>
+/// Stores a value with a full barrier, later loads can not be reordered before the store.
+/// </summary>
+static inline uint64_t i_ae_atomic_exchange(volatile uint64_t* p, uint64_t v)
+{
+	return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+
+/// <summary>
+/// Loads a value without ordering, for counters that are only written by one thread.
+/// </summary>
+static inline uint64_t i_ae_atomic_load_relaxed(volatile uint64_t* p)
+{
+	return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+/// <summary>
+/// Stores a value without ordering, for counters that are only written by one thread.
+/// </summary>
+static inline void i_ae_atomic_store_relaxed(volatile uint64_t* p, uint64_t v)
+{
+	__atomic_store_n(p, v, __ATOMIC_RELAXED);
+}
+
+#endif // AE_WINDOWS
+
+// Time ---------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Returns the current wall clock time in nanoseconds since the Unix epoch.
+/// </summary>
+static inline uint64_t i_ae_time_now(void)
+{
+#ifdef AE_WINDOWS
+	FILETIME ft;
+	GetSystemTimePreciseAsFileTime(&ft);
+
+	uint64_t t = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+	return (t - 116444736000000000ULL) * 100;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif // AE_WINDOWS
+}
+
+/// <summary>
+/// Returns a steady time in nanoseconds that is only meaningful as a difference.
+/// </summary>
+static inline uint64_t i_ae_time_monotonic(void)
+{
+#ifdef AE_WINDOWS
+	LARGE_INTEGER c, f;
+	QueryPerformanceCounter(&c);
+	QueryPerformanceFrequency(&f);
+
+	return (uint64_t)(c.QuadPart / f.QuadPart) * 1000000000ULL + (uint64_t)(c.QuadPart % f.QuadPart) * 1000000000ULL / (uint64_t)f.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif // AE_WINDOWS
+}
+
+/// <summary>
+/// Renders a time from i_ae_time_now() as 'YYYY-MM-DDTHH:MM:SS.uuuuuuZ' (27 characters).
+/// </summary>
+static inline int i_ae_time_render(uint64_t t, char* out, size_t size)
+{
+	time_t s = (time_t)(t / 1000000000ULL);
+	struct tm tm;
+	gmtime_s(&tm, &s);
+
+	return sprintf_s(out, size, "%04d-%02d-%02dT%02d:%02d:%02d.%06uZ", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+		tm.tm_hour, tm.tm_min, tm.tm_sec, (unsigned int)((t % 1000000000ULL) / 1000));
+}
+
+// Threads ------------------------------------------------------------------------------------------------------
+
+#ifdef AE_WINDOWS
+
+typedef HANDLE i_ae_thread;
+typedef SRWLOCK i_ae_mutex;
+typedef DWORD i_ae_tls_key;
+
+#define I_AE_MUTEX_INIT SRWLOCK_INIT
+
+/// <summary>
+/// Declares a function that can be started with i_ae_thread_create().
+/// </summary>
+#define I_AE_THREAD_FUNCTION(name, arg) static DWORD WINAPI name(LPVOID arg)
+#define I_AE_THREAD_RETURN return 0
+
+#define i_ae_thread_create(t, fn, arg) ((*(t) = CreateThread(NULL, 0, fn, arg, 0, NULL)) != NULL)
+#define i_ae_thread_join(t) (WaitForSingleObject(t, INFINITE), CloseHandle(t))
+
+#define i_ae_mutex_lock(m) AcquireSRWLockExclusive(m)
+#define i_ae_mutex_unlock(m) ReleaseSRWLockExclusive(m)
+
+// Fiber local storage is used since it, unlike thread local storage, calls a destructor on thread exit
+#define i_ae_tls_key_create(k, d) ((*(k) = FlsAlloc((PFLS_CALLBACK_FUNCTION)(d))) != FLS_OUT_OF_INDEXES)
+#define i_ae_tls_set(k, v) FlsSetValue(k, v)
+
+#define i_ae_sleep_us(us) Sleep((DWORD)((us) / 1000))
+#define i_ae_yield() SwitchToThread()
+
+#else
+
+typedef pthread_t i_ae_thread;
+typedef pthread_mutex_t i_ae_mutex;
+typedef pthread_key_t i_ae_tls_key;
+
+#define I_AE_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+
+/// <summary>
+/// Declares a function that can be started with i_ae_thread_create().
+/// </summary>
+#define I_AE_THREAD_FUNCTION(name, arg) static void* name(void* arg)
+#define I_AE_THREAD_RETURN return NULL
+
+#define i_ae_thread_create(t, fn, arg) (pthread_create(t, NULL, fn, arg) == 0)
+#define i_ae_thread_join(t) pthread_join(t, NULL)
+
+#define i_ae_mutex_lock(m) pthread_mutex_lock(m)
+#define i_ae_mutex_unlock(m) pthread_mutex_unlock(m)
+
+#define i_ae_tls_key_create(k, d) (pthread_key_create(k, d) == 0)
+#define i_ae_tls_set(k, v) pthread_setspecific(k, v)
+
+#define i_ae_sleep_us(us) usleep((useconds_t)(us))
+#define i_ae_yield() sched_yield()
+
+#endif // AE_WINDOWS
+
+// Parking ------------------------------------------------------------------------------------------------------
+
+#if defined(_MSC_VER)
+#pragma comment(lib, "Synchronization.lib")
+#define i_ae_spin_pause() YieldProcessor()
+#elif defined(__x86_64__) || defined(__i386__)
+#define i_ae_spin_pause() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define i_ae_spin_pause() __asm__ __volatile__("yield")
+#else
+#define i_ae_spin_pause() ((void)0)
+#endif // _MSC_VER
+
+/// <summary>
+/// Reads the word a thread parks on. The value is passed to i_ae_park() so that a wake that happens in between
+/// is not missed.
+/// </summary>
+static inline uint32_t i_ae_park_prepare(volatile uint32_t* word)
+{
+#ifdef AE_WINDOWS
+	return (uint32_t)_InterlockedCompareExchange((volatile long*)word, 0, 0);
+#else
+	return __atomic_load_n(word, __ATOMIC_ACQUIRE);
+#endif // AE_WINDOWS
+}
+
+/// <summary>
+/// Blocks the calling thread while the word still holds the value from i_ae_park_prepare(), until
+/// i_ae_unpark() is called or the timeout in nanoseconds has passed. May return early. MacOS has no public
+/// futex, so the thread sleeps for at most 1 ms there instead.
+/// </summary>
+static inline void i_ae_park(volatile uint32_t* word, uint32_t expected, uint64_t timeout)
+{
+#if defined(AE_WINDOWS)
+	WaitOnAddress((volatile VOID*)word, &expected, sizeof(uint32_t), timeout == UINT64_MAX ? INFINITE : (DWORD)(timeout / 1000000));
+#elif defined(AE_LINUX)
+	struct timespec ts = { (time_t)(timeout / 1000000000ULL), (long)(timeout % 1000000000ULL) };
+	syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, timeout == UINT64_MAX ? NULL : &ts, NULL, 0);
+#else
+	if (__atomic_load_n(word, __ATOMIC_ACQUIRE) == expected)
+	{
+		i_ae_sleep_us(timeout < 1000000ULL ? timeout / 1000 : 1000);
+	}
+#endif // AE_WINDOWS
+}
+
+/// <summary>
+/// Changes the word and wakes a thread that is parked on it.
+/// </summary>
+static inline void i_ae_unpark(volatile uint32_t* word)
+{
+#if defined(AE_WINDOWS)
+	_InterlockedIncrement((volatile long*)word);
+	WakeByAddressSingle((PVOID)word);
+#elif defined(AE_LINUX)
+	__atomic_add_fetch(word, 1, __ATOMIC_RELEASE);
+	syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+	__atomic_add_fetch(word, 1, __ATOMIC_RELEASE);
+#endif // AE_WINDOWS
+}
+
+// Process ------------------------------------------------------------------------------------------------------
+
+static inline int i_ae_process_id(void)
+{
+#ifdef AE_WINDOWS
+	return _getpid();
+#else
+	return (int)getpid();
+#endif // AE_WINDOWS
+}
+
+/// <summary>
+/// Returns the id the operating system uses for the calling thread.
+/// </summary>
+static inline uint64_t i_ae_thread_id(void)
+{
+#if defined(AE_WINDOWS)
+	return (uint64_t)GetCurrentThreadId();
+#elif defined(AE_LINUX)
+	return (uint64_t)syscall(SYS_gettid);
+#else
+	uint64_t id = 0;
+	pthread_threadid_np(NULL, &id);
+	return id;
+#endif // AE_WINDOWS
+}
@@ -0,0 +1,80 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+
+	Internal layout of the shared-memory ring used by the shared-memory sink (ae_shm.c)
+	and the Collector. Each process owns one ring named '/<name>-<pid>'. Producers in
+	the process reserve slots with a single compare-and-swap on the head, copy the
+	record and publish it by storing the slot sequence. The collector is the only
+	consumer of a ring and advances the tail.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define AE_SHM_MAGIC 0x474E495248534541ULL // "AESHRING"
+#define AE_SHM_VERSION 2
+
+#define AE_SHM_SLOT_SIZE 1024
+#define AE_SHM_CACHE_LINE 64
+
+/// <summary>
+/// Header at the start of every ring. The head and tail are kept on separate cache
+/// lines so that producers and the collector do not bounce the same line.
+/// </summary>
+typedef struct
+{
+	uint64_t magic;
+	uint32_t version;
+	uint32_t slot_count;
+	uint32_t slot_size;
+	int32_t pid;
+	char padding_0[AE_SHM_CACHE_LINE - 24];
+
+	volatile uint64_t head;
+	char padding_1[AE_SHM_CACHE_LINE - 8];
+
+	volatile uint64_t tail;
+	char padding_2[AE_SHM_CACHE_LINE - 8];
+
+	volatile uint64_t dropped;
+	char padding_3[AE_SHM_CACHE_LINE - 8];
+} ae_shm_header;
+
+/// <summary>
+/// A slot holds one record. 'sequence' equals the slot position while the slot is
+/// free, position + 1 once the record is published and position + slot_count once
+/// the collector has consumed it. The file name is stored first in 'data',
+/// immediately followed by the message. The thread name is not null terminated if
+/// it fills the field.
+/// </summary>
+typedef struct
+{
+	volatile uint64_t sequence;
+	uint64_t time;
+	int32_t level;
+	int32_t line;
+	uint32_t file_length;
+	uint32_t message_length;
+	uint64_t thread;
+	uint64_t thread_sequence;
+	char thread_name[16];
+	char data[AE_SHM_SLOT_SIZE - 64];
+} ae_shm_slot;
+
+/// <summary>
+/// Returns the size in bytes of a ring with the specified number of slots.
+/// </summary>
+static inline uint64_t i_ae_shm_size(uint32_t slot_count)
+{
+	return sizeof(ae_shm_header) + (uint64_t)slot_count * sizeof(ae_shm_slot);
+}
+
+/// <summary>
+/// Returns the slot at the specified position of a mapped ring.
+/// </summary>
+static inline ae_shm_slot* i_ae_shm_slot(ae_shm_header* h, uint64_t position)
+{
+	return (ae_shm_slot*)((char*)h + sizeof(ae_shm_header)) + (position & (h->slot_count - 1));
+}
@@ -0,0 +1,1169 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define AE_LOG_ASYNC_MAX_THREADS 256
+
+#define AE_LOG_ASYNC_DEFAULT_THREADS 64
+#define AE_LOG_ASYNC_DEFAULT_BUFFER_SIZE (1 << 20)
+#define AE_LOG_ASYNC_DEFAULT_WINDOW 10000
+#define AE_LOG_ASYNC_DEFAULT_PRIORITY ERROR
+#define AE_LOG_ASYNC_DEFAULT_FLUSH_SIZE (64 << 10)
+#define AE_LOG_ASYNC_DEFAULT_FLUSH_LATENCY 20000
+#define AE_LOG_ASYNC_DEFAULT_IDLE_SPIN 50
+
+// A writer with nothing to write still wakes up this often to free the buffers of threads that have exited
+#define AE_LOG_ASYNC_IDLE_TIMEOUT 1000000000ULL
+
+// The shards after the thread shards are shared, the first by the threads that did not get their own and
+// the second by every record in the priority lane
+#define AE_LOG_ASYNC_SHARED_SHARDS 2
+
+enum
+{
+	SHARD_FREE = 0, SHARD_CLAIMED, SHARD_ORPHANED
+};
+
+enum
+{
+	WRITER_AWAKE = 0, WRITER_IDLE, WRITER_WAITING
+};
+
+/// <summary>
+/// Header of a record in a shard, immediately followed by the message and the encoded context of the thread.
+/// The size includes the header and is a multiple of 8. A record with a negative level is padding at the end
+/// of the buffer. A record with bytes from AE_LOG_FILE_HEX has the offset and size of the blob after the
+/// context, followed by the bytes.
+/// </summary>
+typedef struct
+{
+	uint32_t size;
+	int32_t level;
+	int32_t line;
+	uint32_t length;
+	const char* file;
+	uint64_t time;
+	uint64_t sequence;
+	uint64_t thread;
+	const i_ae_callsite* site;
+	uint32_t rate;
+	uint32_t data_length;
+	uint32_t context_length;
+	char thread_name[AE_LOG_THREAD_NAME_SIZE];
+} shard_record;
+
+/// <summary>
+/// A single producer, single consumer buffer owned by one logging thread. The fields written by the
+/// producer, the writer thread and both are kept on separate cache lines.
+/// </summary>
+typedef struct
+{
+	volatile uint64_t head;
+	volatile uint64_t busy;
+	volatile uint64_t dropped;
+	char padding_0[AE_CACHE_LINE - 24];
+
+	volatile uint64_t tail;
+	char padding_1[AE_CACHE_LINE - 8];
+
+	volatile uint64_t state;
+	volatile uint64_t generation;
+	char* data;
+	uint64_t mask;
+	int memory;
+	char padding_2[AE_CACHE_LINE - 40];
+} shard;
+
+typedef struct
+{
+	shard_record* record;
+	shard* shard;
+} merge_entry;
+
+static AE_ALIGN(AE_CACHE_LINE) shard s_shards[AE_LOG_ASYNC_MAX_THREADS + AE_LOG_ASYNC_SHARED_SHARDS];
+static uint32_t s_shard_count = 0;
+static i_ae_mutex s_overflow_mutex = I_AE_MUTEX_INIT;
+static i_ae_mutex s_priority_mutex = I_AE_MUTEX_INIT;
+static uint64_t s_window = 0;
+static int s_drop = 0;
+static log_level s_priority = TRACE;
+static uint64_t s_flush_size = 0;
+static uint64_t s_latency = 0;
+static uint64_t s_spin = 0;
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+static i_ae_thread s_writer;
+static i_ae_tls_key s_key;
+static int s_key_created = 0;
+
+static volatile uint64_t s_running = 0;
+static volatile uint64_t s_stopping = 0;
+static volatile uint64_t s_flushing = 0;
+static volatile uint64_t s_generation = 0;
+
+// Whether the writer thread is parked, and the word it is parked on
+static volatile uint64_t s_parked = WRITER_AWAKE;
+static volatile uint32_t s_wake = 0;
+
+static AE_THREAD_LOCAL shard* t_shard = NULL;
+static AE_THREAD_LOCAL uint64_t t_generation = 0;
+
+static merge_entry s_heap[AE_LOG_ASYNC_MAX_THREADS + 1];
+
+static uint64_t record_size(uint64_t length)
+{
+	return (sizeof(shard_record) + length + 7) & ~7ULL;
+}
+
+static uint64_t record_payload(const ae_record* r)
+{
+	return r->length + r->context_length + (r->data ? 2 * sizeof(uint64_t) + r->data_length : 0);
+}
+
+/// <summary>
+/// Returns 1 if records of the level skip the thread buffers and are written by the writer thread first.
+/// </summary>
+static int priority_lane(log_level l)
+{
+	return s_priority != TRACE && l >= s_priority;
+}
+
+static shard* priority_shard(void)
+{
+	return &s_shards[s_shard_count + 1];
+}
+
+/// <summary>
+/// Wakes the writer thread if it is parked and a record that was just published to the shard should be written.
+/// A writer that has nothing to write is woken by any record, while a writer that waits for the oldest record to
+/// become due is only woken by a full buffer or the priority lane. Without a shard the writer is always woken.
+/// </summary>
+static void writer_wake(shard* s)
+{
+	uint64_t parked = i_ae_atomic_load(&s_parked);
+
+	if (parked == WRITER_AWAKE)
+	{
+		return;
+	}
+
+	if (parked == WRITER_WAITING && s && s != priority_shard()
+		&& i_ae_atomic_load(&s->head) - i_ae_atomic_load(&s->tail) < s_flush_size)
+	{
+		return;
+	}
+
+	if (i_ae_atomic_cas(&s_parked, parked, WRITER_AWAKE))
+	{
+		i_ae_unpark(&s_wake);
+	}
+}
+
+// Shards -------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Called when a thread that owns a shard exits. The writer thread frees the shard once it is drained.
+/// </summary>
+static void shard_release(void* key)
+{
+	uint64_t k = (uint64_t)(uintptr_t)key;
+	shard* s = &s_shards[k & 0xFFFF];
+
+	if (i_ae_atomic_load(&s->generation) == k >> 16)
+	{
+		i_ae_atomic_cas(&s->state, SHARD_CLAIMED, SHARD_ORPHANED);
+	}
+
+	t_shard = NULL;
+	t_generation = 0;
+}
+
+static shard* shard_claim(uint64_t generation)
+{
+	for (uint32_t i = 0; i < s_shard_count; i++)
+	{
+		shard* s = &s_shards[i];
+
+		if (i_ae_atomic_load(&s->state) == SHARD_FREE && i_ae_atomic_cas(&s->state, SHARD_FREE, SHARD_CLAIMED))
+		{
+			t_shard = s;
+			t_generation = generation;
+
+			// The buffer is written by this thread from now on, so it is moved to the memory of its node
+			i_ae_memory_place(s->data, s->mask + 1, s->memory);
+
+			i_ae_tls_set(s_key, (void*)(uintptr_t)((generation << 16) | i));
+			return s;
+		}
+	}
+
+	return NULL;
+}
+
+/// <summary>
+/// Returns the shard of the calling thread, which is claimed once per start of the writer. A thread that did not
+/// get one is given NULL without looking again until the writer is restarted, and uses the overflow shard.
+/// </summary>
+static shard* shard_get(uint64_t generation)
+{
+	if (t_generation != generation)
+	{
+		t_shard = NULL;
+
+		if (!shard_claim(generation))
+		{
+			t_generation = generation;
+		}
+	}
+
+	return t_shard;
+}
+
+/// <summary>
+/// Returns the oldest record of a shard, or NULL if it is empty. Skips padding.
+/// </summary>
+static shard_record* shard_peek(shard* s)
+{
+	for (;;)
+	{
+		uint64_t tail = s->tail;
+
+		if (tail == i_ae_atomic_load(&s->head))
+		{
+			return NULL;
+		}
+
+		shard_record* r = (shard_record*)(s->data + (tail & s->mask));
+
+		if (r->level >= 0)
+		{
+			return r;
+		}
+
+		i_ae_atomic_store(&s->tail, tail + r->size);
+	}
+}
+
+enum
+{
+	SHARD_RESERVED = 0, SHARD_DROPPED, SHARD_STOPPED, SHARD_FULL
+};
+
+/// <summary>
+/// Waits for contiguous space in a shard, or returns SHARD_FULL instead of waiting if wait is 0. A full thread
+/// shard returns SHARD_DROPPED instead if records are dropped, while the priority lane is always waited for. On
+/// success the head and offset of the space are returned, with padding written at the end of the buffer if the
+/// space starts over at the beginning.
+/// </summary>
+static int shard_reserve(shard* s, uint64_t needed, int wait, uint64_t* head_out, uint64_t* offset_out)
+{
+	uint64_t capacity = s->mask + 1;
+
+	for (;;)
+	{
+		uint64_t head = s->head;
+		uint64_t offset = head & s->mask;
+
+		uint64_t used = head - i_ae_atomic_load(&s->tail);
+		uint64_t contiguous = capacity - offset;
+
+		// Records never wrap, the end of the buffer is skipped with padding if the record does not fit
+		if (contiguous < needed && used + contiguous + needed <= capacity)
+		{
+			shard_record* padding = (shard_record*)(s->data + offset);
+			padding->size = (uint32_t)contiguous;
+			padding->level = -1;
+
+			*head_out = head + contiguous;
+			*offset_out = 0;
+			return SHARD_RESERVED;
+		}
+
+		else if (contiguous >= needed && used + needed <= capacity)
+		{
+			*head_out = head;
+			*offset_out = offset;
+			return SHARD_RESERVED;
+		}
+
+		// A writer that is parked until a deadline is woken so that the buffer does not stay full until then
+		writer_wake(NULL);
+
+		// The priority lane is never dropped from, it is emptied first so the wait is short
+		if (s_drop && s != priority_shard())
+		{
+			return SHARD_DROPPED;
+		}
+
+		if (!i_ae_atomic_load(&s_running))
+		{
+			return SHARD_STOPPED;
+		}
+
+		if (!wait)
+		{
+			return SHARD_FULL;
+		}
+
+		i_ae_yield();
+	}
+}
+
+/// <summary>
+/// Formats a record into a shard. Returns 0 if the writer was stopped or restarted since the calling thread
+/// looked up the shard, or if the message is too long for the shard, in which case the record must be emitted
+/// synchronously. The length of a message that was too long is left in the record.
+/// </summary>
+static int shard_write(shard* s, uint64_t generation, ae_record* r, const char* f, va_list args)
+{
+	// The busy flag tells ae_log_file_async_stop() that the buffer is in use, the running flag is checked
+	// after it is set so that the writer is never stopped while a record is being written
+	i_ae_atomic_exchange(&s->busy, 1);
+
+	if (!i_ae_atomic_load(&s_running) || i_ae_atomic_load(&s->generation) != generation)
+	{
+		i_ae_atomic_store(&s->busy, 0);
+		return 0;
+	}
+
+	// Most messages fit in the first reservation, a longer one is formatted again once its length is known
+	uint64_t reserved = f ? AE_LOG_FILE_BUFFER_SIZE : 0;
+	int retried = 0;
+	uint64_t head = 0;
+	uint64_t offset = 0;
+
+	shard_record* record = NULL;
+	char* message = NULL;
+	uint64_t length = 0;
+
+	va_list retry;
+	va_copy(retry, args);
+
+	for (;;)
+	{
+		int status = shard_reserve(s, record_size(reserved + 1 + r->context_length), 1, &head, &offset);
+
+		if (status != SHARD_RESERVED)
+		{
+			if (status == SHARD_DROPPED)
+			{
+				s->dropped++;
+				i_ae_stats_add(AE_STATS_DROPPED, 1);
+			}
+
+			va_end(retry);
+			i_ae_atomic_store(&s->busy, 0);
+			return status == SHARD_DROPPED;
+		}
+
+		// The record is stamped once it has space so that the records of every shard are in time order
+		r->time = i_ae_time_now();
+
+		record = (shard_record*)(s->data + offset);
+		message = (char*)(record + 1);
+
+		if (!f)
+		{
+			break;
+		}
+
+		int n = vsnprintf(message, (size_t)reserved + 1, f, retried ? retry : args);
+		length = n < 0 ? 0 : (uint64_t)n;
+
+		if (length <= reserved)
+		{
+			break;
+		}
+
+		// Messages that would take up a large part of the shard are written synchronously instead
+		if (record_size(length + 1 + r->context_length) > (s->mask + 1) / 4)
+		{
+			va_end(retry);
+			i_ae_atomic_store(&s->busy, 0);
+
+			r->length = length;
+			return 0;
+		}
+
+		reserved = length;
+		retried = 1;
+	}
+
+	va_end(retry);
+
+	// The context overwrites the null character after the message
+	memcpy(message + length, r->context, (size_t)r->context_length);
+
+	record->size = (uint32_t)record_size(length + r->context_length);
+	record->level = (int32_t)r->level;
+	record->line = r->line;
+	record->length = (uint32_t)length;
+	record->file = r->file;
+	record->time = r->time;
+	record->sequence = r->sequence;
+	record->thread = r->thread;
+	memcpy(record->thread_name, r->thread_name, AE_LOG_THREAD_NAME_SIZE);
+	record->site = r->site;
+	record->rate = r->rate;
+	record->data_length = 0;
+	record->context_length = (uint32_t)r->context_length;
+
+	r->message = message;
+	r->length = length;
+
+	i_ae_log_shm_write(r);
+	i_ae_log_trace_write(r);
+
+	i_ae_atomic_store(&s->head, head + record->size);
+
+	// The full barrier keeps the check of whether the writer is parked after the head is published
+	i_ae_atomic_exchange(&s->busy, 0);
+	writer_wake(s);
+	return 1;
+}
+
+int i_ae_async_write(ae_record* r, const char* f, va_list args)
+{
+	if (!s_running)
+	{
+		return 0;
+	}
+
+	if (priority_lane(r->level))
+	{
+		i_ae_mutex_lock(&s_priority_mutex);
+
+		int written = shard_write(priority_shard(), i_ae_atomic_load(&s_generation), r, f, args);
+
+		i_ae_mutex_unlock(&s_priority_mutex);
+		return written;
+	}
+
+	uint64_t generation = i_ae_atomic_load(&s_generation);
+	shard* s = shard_get(generation);
+
+	if (s)
+	{
+		return shard_write(s, generation, r, f, args);
+	}
+
+	i_ae_mutex_lock(&s_overflow_mutex);
+
+	int written = shard_write(&s_shards[s_shard_count], generation, r, f, args);
+
+	i_ae_mutex_unlock(&s_overflow_mutex);
+	return written;
+}
+
+/// <summary>
+/// Copies formatted records into a shard with one reservation and one publish. Returns how many of the records,
+/// counted from the first, were written or dropped, which is at most as many as fit in a quarter of the shard.
+/// </summary>
+static uint32_t shard_write_records(shard* s, uint64_t generation, ae_record* r, uint32_t count)
+{
+	i_ae_atomic_exchange(&s->busy, 1);
+
+	if (!i_ae_atomic_load(&s_running) || i_ae_atomic_load(&s->generation) != generation)
+	{
+		i_ae_atomic_store(&s->busy, 0);
+		return 0;
+	}
+
+	// As many records as fit in a quarter of the shard are reserved together, like a single long message
+	uint64_t limit = (s->mask + 1) / 4;
+	uint64_t needed = 0;
+	uint32_t n = 0;
+
+	while (n < count && needed + record_size(record_payload(&r[n])) <= limit)
+	{
+		needed += record_size(record_payload(&r[n]));
+		n++;
+	}
+
+	uint64_t head = 0;
+	uint64_t offset = 0;
+	// A full shard is not waited for, the caller flushes it and writes the rest synchronously, which is faster
+	// than waiting for the writer to release the records one reorder window at a time
+	int status = n > 0 ? shard_reserve(s, needed, 0, &head, &offset) : SHARD_STOPPED;
+
+	if (status != SHARD_RESERVED)
+	{
+		if (status == SHARD_DROPPED)
+		{
+			s->dropped += n;
+			i_ae_stats_add(AE_STATS_DROPPED, n);
+		}
+
+		i_ae_atomic_store(&s->busy, 0);
+		return status == SHARD_DROPPED ? n : 0;
+	}
+
+	uint64_t time = i_ae_time_now();
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		shard_record* record = (shard_record*)(s->data + offset);
+		char* message = (char*)(record + 1);
+
+		char* payload = message + r[i].length + r[i].context_length;
+
+		memcpy(message, r[i].message, (size_t)r[i].length);
+		memcpy(message + r[i].length, r[i].context, (size_t)r[i].context_length);
+
+		if (r[i].data)
+		{
+			memcpy(payload, &r[i].data_offset, sizeof(uint64_t));
+			memcpy(payload + sizeof(uint64_t), &r[i].data_size, sizeof(uint64_t));
+			memcpy(payload + 2 * sizeof(uint64_t), r[i].data, (size_t)r[i].data_length);
+		}
+
+		record->size = (uint32_t)record_size(record_payload(&r[i]));
+		record->level = (int32_t)r[i].level;
+		record->line = r[i].line;
+		record->length = (uint32_t)r[i].length;
+		record->file = r[i].file;
+		record->time = time;
+		record->sequence = r[i].sequence;
+		record->thread = r[i].thread;
+		memcpy(record->thread_name, r[i].thread_name, AE_LOG_THREAD_NAME_SIZE);
+		record->site = r[i].site;
+		record->rate = r[i].rate;
+		record->data_length = (uint32_t)r[i].data_length;
+		record->context_length = (uint32_t)r[i].context_length;
+
+		r[i].time = time;
+
+		i_ae_log_shm_write(&r[i]);
+		i_ae_log_trace_write(&r[i]);
+
+		offset += record->size;
+	}
+
+	i_ae_atomic_store(&s->head, head + needed);
+
+	i_ae_atomic_exchange(&s->busy, 0);
+	writer_wake(s);
+	return n;
+}
+
+/// <summary>
+/// Copies as many records as fit in one reservation into the shard they belong in. Returns how many were taken.
+/// </summary>
+static uint32_t async_write_group(ae_record* r, uint32_t count)
+{
+	if (priority_lane(r[0].level))
+	{
+		// Only the records that belong in the lane are taken, the rest are emitted synchronously after them
+		uint32_t n = 1;
+
+		while (n < count && priority_lane(r[n].level))
+		{
+			n++;
+		}
+
+		i_ae_mutex_lock(&s_priority_mutex);
+
+		uint32_t written = shard_write_records(priority_shard(), i_ae_atomic_load(&s_generation), r, n);
+
+		i_ae_mutex_unlock(&s_priority_mutex);
+		return written;
+	}
+
+	uint64_t generation = i_ae_atomic_load(&s_generation);
+	shard* s = shard_get(generation);
+
+	if (s)
+	{
+		return shard_write_records(s, generation, r, count);
+	}
+
+	i_ae_mutex_lock(&s_overflow_mutex);
+
+	uint32_t written = shard_write_records(&s_shards[s_shard_count], generation, r, count);
+
+	i_ae_mutex_unlock(&s_overflow_mutex);
+	return written;
+}
+
+uint32_t i_ae_async_write_records(ae_record* r, uint32_t count)
+{
+	if (!s_running)
+	{
+		return 0;
+	}
+
+	// Each group is one reservation and one publish of up to a quarter of a shard. The loop ends when the shard
+	// is full and records are not dropped, when a record does not fit in a quarter or when the writer stopped.
+	uint32_t written = 0;
+
+	while (written < count)
+	{
+		uint32_t n = async_write_group(r + written, count - written);
+
+		if (n == 0)
+		{
+			break;
+		}
+
+		written += n;
+	}
+
+	return written;
+}
+
+// Writer -------------------------------------------------------------------------------------------------------
+
+static int merge_less(const merge_entry* a, const merge_entry* b)
+{
+	if (a->record->time != b->record->time)
+	{
+		return a->record->time < b->record->time;
+	}
+
+	if (a->record->sequence != b->record->sequence)
+	{
+		return a->record->sequence < b->record->sequence;
+	}
+
+	return a->shard < b->shard;
+}
+
+static void heap_sift_down(uint32_t count, uint32_t i)
+{
+	for (;;)
+	{
+		uint32_t smallest = i;
+		uint32_t left = 2 * i + 1;
+		uint32_t right = left + 1;
+
+		if (left < count && merge_less(&s_heap[left], &s_heap[smallest]))
+		{
+			smallest = left;
+		}
+
+		if (right < count && merge_less(&s_heap[right], &s_heap[smallest]))
+		{
+			smallest = right;
+		}
+
+		if (smallest == i)
+		{
+			return;
+		}
+
+		merge_entry e = s_heap[i];
+		s_heap[i] = s_heap[smallest];
+		s_heap[smallest] = e;
+
+		i = smallest;
+	}
+}
+
+/// <summary>
+/// Writes the oldest record of a shard to the log file and removes it from the shard.
+/// </summary>
+static void record_emit(shard* s, shard_record* sr)
+{
+	ae_record r = { (log_level)sr->level, sr->line, sr->file, sr->time, sr->sequence, sr->thread, sr->thread_name,
+		(const char*)(sr + 1), sr->length, sr->site, sr->rate, NULL, 0, 0, 0, (const char*)(sr + 1) + sr->length,
+		sr->context_length };
+
+	if (sr->data_length > 0)
+	{
+		const char* payload = r.context + sr->context_length;
+
+		memcpy(&r.data_offset, payload, sizeof(uint64_t));
+		memcpy(&r.data_size, payload + sizeof(uint64_t), sizeof(uint64_t));
+
+		r.data = (const unsigned char*)payload + 2 * sizeof(uint64_t);
+		r.data_length = sr->data_length;
+	}
+
+	i_ae_log_file_emit(&r);
+
+	i_ae_atomic_store(&s->tail, s->tail + sr->size);
+}
+
+/// <summary>
+/// Emits every record in the priority lane. The lane is shared under a lock and stamped after space is
+/// reserved, so it is already in time order and is not held back for the reorder window.
+/// </summary>
+static uint64_t priority_drain(void)
+{
+	shard* s = priority_shard();
+	uint64_t emitted = 0;
+
+	for (shard_record* r = shard_peek(s); r; r = shard_peek(s))
+	{
+		record_emit(s, r);
+		emitted++;
+	}
+
+	return emitted;
+}
+
+/// <summary>
+/// K-way merges the shards and emits every record older than the horizon in time order. Each shard is
+/// already ordered, so only the oldest record of each shard has to be compared. The priority lane is
+/// drained whenever it has records, even in the middle of a long backlog. The time of the oldest record
+/// that is left is returned in 'oldest', or UINT64_MAX if the shards are empty.
+/// </summary>
+static uint64_t shards_merge(uint64_t horizon, uint64_t* oldest)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i <= s_shard_count; i++)
+	{
+		shard* s = &s_shards[i];
+		shard_record* r = i_ae_atomic_load(&s->state) != SHARD_FREE ? shard_peek(s) : NULL;
+
+		if (r)
+		{
+			s_heap[count].record = r;
+			s_heap[count].shard = s;
+			count++;
+		}
+	}
+
+	for (uint32_t i = count / 2; i-- > 0;)
+	{
+		heap_sift_down(count, i);
+	}
+
+	shard* priority = priority_shard();
+	uint64_t emitted = priority_drain();
+
+	while (count > 0 && s_heap[0].record->time <= horizon)
+	{
+		if (i_ae_atomic_load(&priority->head) != priority->tail)
+		{
+			emitted += priority_drain();
+		}
+
+		shard* s = s_heap[0].shard;
+
+		record_emit(s, s_heap[0].record);
+		emitted++;
+
+		shard_record* next = shard_peek(s);
+
+		if (next)
+		{
+			s_heap[0].record = next;
+		}
+
+		else
+		{
+			s_heap[0] = s_heap[--count];
+		}
+
+		heap_sift_down(count, 0);
+	}
+
+	*oldest = count > 0 ? s_heap[0].record->time : UINT64_MAX;
+	return emitted;
+}
+
+/// <summary>
+/// Frees the shards of threads that have exited once everything they logged has been emitted.
+/// </summary>
+static void shards_recycle(void)
+{
+	for (uint32_t i = 0; i < s_shard_count; i++)
+	{
+		shard* s = &s_shards[i];
+
+		if (i_ae_atomic_load(&s->state) == SHARD_ORPHANED && s->tail == i_ae_atomic_load(&s->head))
+		{
+			i_ae_atomic_cas(&s->state, SHARD_ORPHANED, SHARD_FREE);
+		}
+	}
+}
+
+/// <summary>
+/// Returns 1 if the buffer of a thread holds at least the flush size.
+/// </summary>
+static int shards_full(void)
+{
+	for (uint32_t i = 0; i <= s_shard_count; i++)
+	{
+		if (i_ae_atomic_load(&s_shards[i].head) - s_shards[i].tail >= s_flush_size)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Returns when the oldest record in the shards is due to be written. Records in a full buffer are written as
+/// soon as the reorder window allows, other records once they have waited for the flush latency.
+/// </summary>
+static uint64_t writer_due(uint64_t oldest)
+{
+	if (oldest == UINT64_MAX)
+	{
+		return UINT64_MAX;
+	}
+
+	return oldest + (shards_full() ? s_window : s_latency);
+}
+
+/// <summary>
+/// Returns 1 if the writer thread has something to do.
+/// </summary>
+static int writer_ready(uint64_t oldest)
+{
+	shard* priority = priority_shard();
+
+	if (i_ae_atomic_load(&s_stopping) || i_ae_atomic_load(&s_flushing) || i_ae_atomic_load(&priority->head) != priority->tail)
+	{
+		return 1;
+	}
+
+	if (oldest != UINT64_MAX)
+	{
+		return i_ae_time_now() >= writer_due(oldest);
+	}
+
+	for (uint32_t i = 0; i <= s_shard_count; i++)
+	{
+		if (i_ae_atomic_load(&s_shards[i].head) != s_shards[i].tail)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Waits until the writer thread has something to do. The writer spins for the idle spin time, yields for as
+/// long again and then parks until a producer wakes it or the oldest record becomes due.
+/// </summary>
+static void writer_idle(uint64_t oldest)
+{
+	uint64_t start = i_ae_time_monotonic();
+
+	for (;;)
+	{
+		if (writer_ready(oldest))
+		{
+			return;
+		}
+
+		uint64_t waited = i_ae_time_monotonic() - start;
+
+		if (waited >= 2 * s_spin)
+		{
+			break;
+		}
+
+		if (waited < s_spin)
+		{
+			i_ae_spin_pause();
+		}
+
+		else
+		{
+			i_ae_yield();
+		}
+	}
+
+	// The state is published with a full barrier before the shards are checked a last time, so a producer
+	// either sees that the writer is parked or the writer sees its record
+	uint32_t word = i_ae_park_prepare(&s_wake);
+	i_ae_atomic_exchange(&s_parked, oldest == UINT64_MAX ? WRITER_IDLE : WRITER_WAITING);
+
+	if (!writer_ready(oldest))
+	{
+		uint64_t now = i_ae_time_now();
+		uint64_t due = oldest == UINT64_MAX ? now + AE_LOG_ASYNC_IDLE_TIMEOUT : writer_due(oldest);
+
+		i_ae_park(&s_wake, word, due > now ? due - now : 0);
+	}
+
+	i_ae_atomic_exchange(&s_parked, WRITER_AWAKE);
+}
+
+I_AE_THREAD_FUNCTION(writer_main, arg)
+{
+	(void)arg;
+
+	uint64_t oldest = UINT64_MAX;
+
+	for (;;)
+	{
+		int stopping = i_ae_atomic_load(&s_stopping) != 0;
+		uint64_t now = i_ae_time_now();
+
+		// Records are held back for the reorder window, since a thread may still be about to publish a
+		// record with an earlier time than the oldest record that is currently in the shards. Until the
+		// oldest record is due only the priority lane is written.
+		uint64_t horizon = stopping || i_ae_atomic_load(&s_flushing) ? UINT64_MAX : writer_due(oldest) <= now ? now - s_window : 0;
+		uint64_t emitted = shards_merge(horizon, &oldest);
+
+		shards_recycle();
+
+		if (emitted > 0)
+		{
+			continue;
+		}
+
+		if (stopping)
+		{
+			break;
+		}
+
+		writer_idle(oldest);
+	}
+
+	I_AE_THREAD_RETURN;
+}
+
+// Interface ----------------------------------------------------------------------------------------------------
+
+int ae_log_file_async_start(const ae_log_async_config* c)
+{
+	ae_log_async_config config = { AE_LOG_ASYNC_DEFAULT_THREADS, AE_LOG_ASYNC_DEFAULT_BUFFER_SIZE, AE_LOG_ASYNC_DEFAULT_WINDOW, 0,
+		AE_LOG_ASYNC_DEFAULT_PRIORITY, AE_LOG_ASYNC_DEFAULT_FLUSH_SIZE, AE_LOG_ASYNC_DEFAULT_FLUSH_LATENCY, AE_LOG_ASYNC_DEFAULT_IDLE_SPIN };
+
+	if (c)
+	{
+		config = *c;
+	}
+
+	if (config.max_threads == 0 || config.max_threads > AE_LOG_ASYNC_MAX_THREADS || (config.buffer_size & (config.buffer_size - 1)) != 0
+		|| config.buffer_size < 4 * record_size(AE_LOG_FILE_BUFFER_SIZE + 1 + AE_LOG_CONTEXT_SIZE) || config.priority_level < TRACE || config.priority_level > FATAL)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to start asynchronous file logging because the configuration is invalid. At most %d threads are supported, the buffer size must be a power of two of at least %d bytes and the priority level must be a log_level.",
+			AE_LOG_ASYNC_MAX_THREADS, (int)(4 * record_size(AE_LOG_FILE_BUFFER_SIZE + 1 + AE_LOG_CONTEXT_SIZE)));
+		return 0;
+	}
+
+	i_ae_mutex_lock(&s_mutex);
+
+	if (s_running)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		return 1;
+	}
+
+	if (!s_key_created)
+	{
+		s_key_created = i_ae_tls_key_create(&s_key, shard_release);
+	}
+
+	uint64_t generation = s_generation + 1;
+
+	for (uint32_t i = 0; i < config.max_threads + AE_LOG_ASYNC_SHARED_SHARDS; i++)
+	{
+		shard* s = &s_shards[i];
+
+		s->data = i_ae_memory_alloc(config.buffer_size, &s->memory);
+
+		if (!s->data)
+		{
+			while (i-- > 0)
+			{
+				i_ae_memory_free(s_shards[i].data, s_shards[i].mask + 1, s_shards[i].memory);
+				s_shards[i].data = NULL;
+			}
+
+			i_ae_mutex_unlock(&s_mutex);
+
+			AE_LOG_CONSOLE_ERROR("Failed to start asynchronous file logging because the buffers could not be allocated.");
+			return 0;
+		}
+
+		s->mask = config.buffer_size - 1;
+		s->head = 0;
+		s->tail = 0;
+		s->busy = 0;
+		s->dropped = 0;
+		s->state = i < config.max_threads ? SHARD_FREE : SHARD_CLAIMED;
+		i_ae_atomic_store(&s->generation, generation);
+	}
+
+	s_shard_count = config.max_threads;
+	s_window = (uint64_t)config.reorder_window * 1000;
+	s_drop = config.drop_when_full;
+	s_priority = config.priority_level;
+
+	// A buffer must be able to reach the flush size before it is full, and records are never written before
+	// the reorder window has passed
+	s_flush_size = config.flush_size < config.buffer_size / 2 ? config.flush_size : config.buffer_size / 2;
+	s_latency = config.flush_latency > config.reorder_window ? (uint64_t)config.flush_latency * 1000 : s_window;
+	s_spin = (uint64_t)config.idle_spin * 1000;
+	s_parked = WRITER_AWAKE;
+	s_stopping = 0;
+	s_flushing = 0;
+
+	// The generation is published before the running flag so that buffers of a previous start are not reused
+	i_ae_atomic_store(&s_generation, generation);
+
+	if (!s_key_created || !i_ae_thread_create(&s_writer, writer_main, NULL))
+	{
+		for (uint32_t i = 0; i < s_shard_count + AE_LOG_ASYNC_SHARED_SHARDS; i++)
+		{
+			i_ae_memory_free(s_shards[i].data, s_shards[i].mask + 1, s_shards[i].memory);
+			s_shards[i].data = NULL;
+		}
+
+		s_shard_count = 0;
+		i_ae_mutex_unlock(&s_mutex);
+
+		AE_LOG_CONSOLE_ERROR("Failed to start asynchronous file logging because the writer thread could not be created.");
+		return 0;
+	}
+
+	i_ae_atomic_exchange(&s_running, 1);
+
+	i_ae_mutex_unlock(&s_mutex);
+	return 1;
+}
+
+void ae_log_file_async_stop(void)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	if (!s_running)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		return;
+	}
+
+	i_ae_atomic_exchange(&s_running, 0);
+
+	// Threads that saw the running flag before it was cleared finish their record first
+	for (uint32_t i = 0; i < s_shard_count + AE_LOG_ASYNC_SHARED_SHARDS; i++)
+	{
+		while (i_ae_atomic_load(&s_shards[i].busy))
+		{
+			i_ae_yield();
+		}
+	}
+
+	i_ae_atomic_store(&s_stopping, 1);
+	writer_wake(NULL);
+
+	i_ae_thread_join(s_writer);
+
+	uint64_t dropped = 0;
+
+	for (uint32_t i = 0; i < s_shard_count + AE_LOG_ASYNC_SHARED_SHARDS; i++)
+	{
+		shard* s = &s_shards[i];
+
+		dropped += s->dropped;
+
+		i_ae_memory_free(s->data, s->mask + 1, s->memory);
+		s->data = NULL;
+		s->state = SHARD_FREE;
+	}
+
+	s_shard_count = 0;
+
+	i_ae_mutex_unlock(&s_mutex);
+
+	if (dropped > 0)
+	{
+		AE_LOG_CONSOLE_WARNING("%llu file messages were dropped because the buffer of the logging thread was full.", (unsigned long long)dropped);
+	}
+}
+
+void i_ae_async_flush(void)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	if (!s_running)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		return;
+	}
+
+	uint64_t heads[AE_LOG_ASYNC_MAX_THREADS + AE_LOG_ASYNC_SHARED_SHARDS];
+
+	for (uint32_t i = 0; i < s_shard_count + AE_LOG_ASYNC_SHARED_SHARDS; i++)
+	{
+		heads[i] = i_ae_atomic_load(&s_shards[i].head);
+	}
+
+	i_ae_atomic_add(&s_flushing, 1);
+	writer_wake(NULL);
+
+	for (uint32_t i = 0; i < s_shard_count + AE_LOG_ASYNC_SHARED_SHARDS; i++)
+	{
+		while (i_ae_atomic_load(&s_shards[i].tail) < heads[i])
+		{
+			i_ae_sleep_us(100);
+		}
+	}
+
+	i_ae_atomic_add(&s_flushing, (uint64_t)-1);
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+void i_ae_async_flush_level(log_level l)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	if (!s_running)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		return;
+	}
+
+	if (!priority_lane(l))
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		i_ae_async_flush();
+		return;
+	}
+
+	// The lane is emitted before the thread buffers, so only the lane has to be waited for
+	shard* s = priority_shard();
+	uint64_t head = i_ae_atomic_load(&s->head);
+
+	while (i_ae_atomic_load(&s->tail) < head)
+	{
+		i_ae_sleep_us(100);
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+uint64_t i_ae_async_depth(void)
+{
+	uint64_t depth = 0;
+
+	if (!i_ae_atomic_load(&s_running))
+	{
+		return 0;
+	}
+
+	for (uint32_t i = 0; i < s_shard_count + AE_LOG_ASYNC_SHARED_SHARDS; i++)
+	{
+		uint64_t tail = i_ae_atomic_load(&s_shards[i].tail);
+		uint64_t head = i_ae_atomic_load(&s_shards[i].head);
+
+		depth += head > tail ? head - tail : 0;
+	}
+
+	return depth;
+}
+
+void ae_log_file_async_flush(void)
+{
+	i_ae_async_flush();
+}
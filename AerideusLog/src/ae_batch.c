@@ -0,0 +1,228 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Space made per expected record when a batch begins, most messages are shorter than this
+#define AE_LOG_BATCH_RECORD_SIZE 128
+
+// Records are handed to the writer thread, or written to the log file, this many at a time
+#define AE_LOG_BATCH_GROUP 64
+
+/// <summary>
+/// Header of a record in a batch, immediately followed by the message and a null character. The size of the
+/// header, message and null character is rounded up to a multiple of 8.
+/// </summary>
+typedef struct
+{
+	i_ae_callsite* site;
+	uint64_t length;
+} batch_entry;
+
+/// <summary>
+/// The batch of a thread. The buffer is kept between batches and freed when the thread exits.
+/// </summary>
+struct ae_log_batch
+{
+	log_level level;
+	uint32_t count;
+	char* data;
+	uint64_t size;
+	uint64_t capacity;
+};
+
+static AE_THREAD_LOCAL ae_log_batch t_batch;
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+static i_ae_tls_key s_key;
+static volatile uint64_t s_key_created = 0;
+
+static uint64_t entry_size(uint64_t length)
+{
+	return (sizeof(batch_entry) + length + 1 + 7) & ~7ULL;
+}
+
+// Storage ------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Called when a thread that has used a batch exits.
+/// </summary>
+static void batch_release(void* data)
+{
+	free(data);
+
+	t_batch.data = NULL;
+	t_batch.count = 0;
+	t_batch.size = 0;
+	t_batch.capacity = 0;
+}
+
+/// <summary>
+/// Makes room for at least the specified number of bytes in the batch. Returns 0 if memory could not be allocated.
+/// </summary>
+static int batch_grow(ae_log_batch* b, uint64_t size)
+{
+	if (size <= b->capacity)
+	{
+		return 1;
+	}
+
+	if (!i_ae_atomic_load(&s_key_created))
+	{
+		i_ae_mutex_lock(&s_mutex);
+
+		if (!s_key_created && i_ae_tls_key_create(&s_key, batch_release))
+		{
+			i_ae_atomic_store(&s_key_created, 1);
+		}
+
+		i_ae_mutex_unlock(&s_mutex);
+	}
+
+	uint64_t capacity = b->capacity ? b->capacity : AE_LOG_BATCH_RECORD_SIZE * AE_LOG_BATCH_GROUP;
+
+	while (capacity < size)
+	{
+		capacity *= 2;
+	}
+
+	char* data = realloc(b->data, (size_t)capacity);
+
+	if (!data)
+	{
+		i_ae_stats_add(AE_STATS_ALLOCATION_FAILURES, 1);
+		return 0;
+	}
+
+	b->data = data;
+	b->capacity = capacity;
+
+	if (i_ae_atomic_load(&s_key_created))
+	{
+		i_ae_tls_set(s_key, data);
+	}
+
+	return 1;
+}
+
+// Interface ----------------------------------------------------------------------------------------------------
+
+ae_log_batch* i_ae_log_file_batch_begin(i_ae_callsite* s, log_level l, uint32_t count)
+{
+	if (!i_ae_log_file_enabled(s, l))
+	{
+		return NULL;
+	}
+
+	ae_log_batch* b = &t_batch;
+
+	// A batch that was left open is committed so that its records are not lost
+	if (b->count > 0)
+	{
+		ae_log_file_batch_commit(b);
+	}
+
+	b->level = l;
+	b->count = 0;
+	b->size = 0;
+
+	batch_grow(b, (uint64_t)count * AE_LOG_BATCH_RECORD_SIZE);
+	return b;
+}
+
+void i_ae_log_file_batch_add(ae_log_batch* b, i_ae_callsite* s, const char* f, ...)
+{
+	if (!batch_grow(b, b->size + entry_size(0)))
+	{
+		return;
+	}
+
+	va_list args;
+	va_start(args, f);
+
+	uint64_t length;
+
+	// The message is formatted straight into the batch, and again once its length is known if it did not fit
+	for (;;)
+	{
+		uint64_t room = b->capacity - b->size - sizeof(batch_entry);
+
+		va_list copy;
+		va_copy(copy, args);
+
+		int n = vsnprintf(b->data + b->size + sizeof(batch_entry), (size_t)room, f, copy);
+		va_end(copy);
+
+		length = n < 0 ? 0 : (uint64_t)n;
+
+		if (length < room)
+		{
+			break;
+		}
+
+		if (!batch_grow(b, b->size + entry_size(length)))
+		{
+			va_end(args);
+			return;
+		}
+	}
+
+	va_end(args);
+
+	batch_entry* e = (batch_entry*)(b->data + b->size);
+	e->site = s;
+	e->length = length;
+
+	b->size += entry_size(length);
+	b->count++;
+}
+
+void ae_log_file_batch_commit(ae_log_batch* b)
+{
+	if (!b || b->count == 0)
+	{
+		return;
+	}
+
+	i_ae_stats_add(AE_STATS_FILE + b->level, b->count);
+
+	i_ae_thread_info* t = i_ae_thread_info_get();
+	ae_record records[AE_LOG_BATCH_GROUP];
+
+	uint64_t offset = 0;
+	uint32_t left = b->count;
+
+	while (left > 0)
+	{
+		uint32_t n = left < AE_LOG_BATCH_GROUP ? left : AE_LOG_BATCH_GROUP;
+
+		for (uint32_t i = 0; i < n; i++)
+		{
+			batch_entry* e = (batch_entry*)(b->data + offset);
+			ae_record r = { b->level, e->site->line, e->site->file, 0, t->sequence++, t->id, t->name, (const char*)(e + 1),
+				e->length, i_ae_callsite_prefix(e->site, b->level, ""), 0, NULL, 0, 0, 0,
+				t->context->data, t->context->length };
+
+			records[i] = r;
+			offset += entry_size(e->length);
+		}
+
+		left -= n;
+
+		i_ae_log_file_write_records(records, n);
+	}
+
+	// An error batch is made durable once, after all of its records
+	i_ae_log_stream_commit(b->level);
+
+	b->count = 0;
+	b->size = 0;
+}
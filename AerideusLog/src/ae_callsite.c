@@ -0,0 +1,81 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+enum
+{
+	CALLSITE_EMPTY = 0, CALLSITE_RENDERING, CALLSITE_READY, CALLSITE_UNCACHED
+};
+
+static const char* s_labels[5] = { "TRACE", "INFO", "WARNING", "ERROR", "FATAL" };
+
+static AE_THREAD_LOCAL uint64_t t_random = 0;
+
+uint64_t i_ae_callsite_render(char* out, uint64_t size, const char* color, log_level l, const char* fn, int ln)
+{
+	int len = sprintf_s(out, (size_t)size, "%s[%s] %s | Line: %d | Message: '", color, s_labels[l], fn, ln);
+
+	if (len < 0)
+	{
+		return 0;
+	}
+
+	return (uint64_t)len < size ? (uint64_t)len : size - 1;
+}
+
+const i_ae_callsite* i_ae_callsite_prefix(i_ae_callsite* s, log_level l, const char* color)
+{
+	uint64_t state = i_ae_atomic_load(&s->state);
+
+	if (state == CALLSITE_READY)
+	{
+		return s->level == (int)l ? s : NULL;
+	}
+
+	// The first thread to get here renders the prefix, any other thread renders its own until it is ready
+	if (state != CALLSITE_EMPTY || !i_ae_atomic_cas(&s->state, CALLSITE_EMPTY, CALLSITE_RENDERING))
+	{
+		return NULL;
+	}
+
+	int len = sprintf_s(s->prefix, I_AE_CALLSITE_PREFIX_SIZE, "%s[%s] %s | Line: %d | Message: '", color, s_labels[l], s->file, s->line);
+
+	// A prefix that does not fit, for example because of a very long path, is rendered for every message
+	if (len < 0 || len >= I_AE_CALLSITE_PREFIX_SIZE)
+	{
+		i_ae_atomic_store(&s->state, CALLSITE_UNCACHED);
+		return NULL;
+	}
+
+	s->level = (int)l;
+	s->length = (uint32_t)len;
+
+	i_ae_atomic_store(&s->state, CALLSITE_READY);
+	return s;
+}
+
+int i_ae_callsite_hit(uint32_t rate)
+{
+	uint64_t x = t_random;
+
+	// Each thread seeds its generator from its id and the time so that threads do not sample in lockstep
+	if (x == 0)
+	{
+		x = (i_ae_thread_id() * 0x9E3779B97F4A7C15ULL) ^ i_ae_time_monotonic();
+		x = x ? x : 1;
+	}
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+
+	t_random = x;
+
+	// The upper 32 bits are scaled to [0, rate) with a multiplication instead of a division
+	return ((x >> 32) * rate) >> 32 == 0;
+}
@@ -0,0 +1,1009 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef AE_LINUX
+#include <poll.h>
+#include <sys/inotify.h>
+#endif // AE_LINUX
+
+#define AE_LOG_CONFIG_MAX_SIZE 65536
+#define AE_LOG_CONFIG_MAX_FILTERS 64
+#define AE_LOG_CONFIG_PATH_SIZE 256
+
+// How often the watcher checks if it should stop, and how often the file is checked without inotify
+#define AE_LOG_CONFIG_POLL_INTERVAL 250
+
+enum
+{
+	FILTER_LEVEL = 0, FILTER_RATE
+};
+
+/// <summary>
+/// Sets the level or sample rate for callsites in files that match a pattern, where '*' matches any
+/// characters. If the line is not 0, only the callsite on that line matches.
+/// </summary>
+typedef struct
+{
+	int sink;
+	int kind;
+	uint32_t value;
+	int line;
+	char pattern[AE_LOG_CONFIG_PATH_SIZE];
+} config_filter;
+
+/// <summary>
+/// The filters of one version of the configuration. Published as a whole so that a callsite never sees
+/// filters from two versions, and kept until the process exits since a logging thread may still read it.
+/// </summary>
+typedef struct config_filters
+{
+	struct config_filters* previous;
+	uint32_t count;
+	config_filter filters[];
+} config_filters;
+
+/// <summary>
+/// The settings of a configuration file. Settings that are not in the file are -1 or empty and keep their
+/// current value when the file is applied.
+/// </summary>
+typedef struct
+{
+	int console_level;
+	int file_level;
+	int file_format;
+	int64_t file_reserve;
+	int64_t stats_sample;
+	int64_t stats_report;
+	int64_t timer_report;
+
+	char trace[AE_LOG_CONFIG_PATH_SIZE];
+	char socket[AE_LOG_CONFIG_PATH_SIZE];
+	int socket_format;
+
+	char shm[AE_LOG_CONFIG_PATH_SIZE];
+	int64_t shm_slots;
+
+	int async;
+	ae_log_async_config async_config;
+
+	int memory_huge_pages;
+	int memory_numa;
+
+	uint32_t filter_count;
+	config_filter filters[AE_LOG_CONFIG_MAX_FILTERS];
+} config_settings;
+
+// Incremented whenever new filters are published, callsites that cached an older generation look them up again
+static volatile uint64_t s_generation = 0;
+static volatile uint64_t s_filters = 0;
+
+// The lowest level of the filters of each sink, or above FATAL if the sink has no level filters
+static volatile uint64_t s_floors[2] = { FATAL + 1, FATAL + 1 };
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+static config_settings s_applied;
+static int s_loaded = 0;
+
+static i_ae_thread s_watcher;
+static volatile uint64_t s_watching = 0;
+static char s_path[AE_LOG_CONFIG_PATH_SIZE];
+
+static const char* s_labels[5] = { "TRACE", "INFO", "WARNING", "ERROR", "FATAL" };
+
+// Filters ------------------------------------------------------------------------------------------------------
+
+static int pattern_match(const char* pattern, const char* s)
+{
+	const char* star = NULL;
+	const char* resume = NULL;
+
+	while (*s)
+	{
+		if (*pattern == '*')
+		{
+			star = pattern++;
+			resume = s;
+		}
+
+		else if (*pattern == *s)
+		{
+			pattern++;
+			s++;
+		}
+
+		else if (star)
+		{
+			pattern = star + 1;
+			s = ++resume;
+		}
+
+		else
+		{
+			return 0;
+		}
+	}
+
+	while (*pattern == '*')
+	{
+		pattern++;
+	}
+
+	return *pattern == '\0';
+}
+
+/// <summary>
+/// Returns the filter of a callsite. The lowest 8 bits are the level of the matching filter plus one, the next
+/// 32 bits are the rate of the matching sampling filter and the rest is the generation it was looked up for.
+/// Values of 0 mean that no filter matches.
+/// </summary>
+static uint64_t site_filter(i_ae_callsite* s, int sink)
+{
+	uint64_t generation = i_ae_atomic_load(&s_generation) & 0xFFFFFF;
+	uint64_t filter = i_ae_atomic_load_relaxed(&s->filter);
+
+	if ((filter >> 40) == generation)
+	{
+		return filter;
+	}
+
+	const config_filters* c = (const config_filters*)(uintptr_t)i_ae_atomic_load(&s_filters);
+	uint64_t level = 0;
+	uint64_t rate = 0;
+
+	for (uint32_t i = 0; c && i < c->count; i++)
+	{
+		const config_filter* f = &c->filters[i];
+
+		if (f->sink != sink || (f->line != 0 && f->line != s->line) || !pattern_match(f->pattern, s->file))
+		{
+			continue;
+		}
+
+		if (f->kind == FILTER_LEVEL)
+		{
+			level = (uint64_t)f->value + 1;
+		}
+
+		else
+		{
+			rate = f->value;
+		}
+	}
+
+	// Tagged with the generation read before the filters, so that a concurrent change is looked up again
+	filter = (generation << 40) | (rate << 8) | level;
+	i_ae_atomic_store_relaxed(&s->filter, filter);
+
+	return filter;
+}
+
+log_level i_ae_config_level(i_ae_callsite* s, int sink, log_level level)
+{
+	uint64_t filter = site_filter(s, sink) & 0xFF;
+	return filter ? (log_level)(filter - 1) : level;
+}
+
+uint32_t i_ae_config_rate(i_ae_callsite* s, int sink, uint32_t rate)
+{
+	uint32_t filter = (uint32_t)(site_filter(s, sink) >> 8);
+	return filter ? filter : rate;
+}
+
+log_level i_ae_config_floor(int sink, log_level level)
+{
+	uint64_t floor = i_ae_atomic_load(&s_floors[sink]);
+	return floor < (uint64_t)level ? (log_level)floor : level;
+}
+
+/// <summary>
+/// Publishes the filters of a configuration. Must be called with s_mutex locked.
+/// </summary>
+static int filters_publish(const config_settings* c)
+{
+	config_filters* f = malloc(sizeof(config_filters) + c->filter_count * sizeof(config_filter));
+
+	if (!f)
+	{
+		return 0;
+	}
+
+	f->previous = (config_filters*)(uintptr_t)s_filters;
+	f->count = c->filter_count;
+
+	memcpy(f->filters, c->filters, c->filter_count * sizeof(config_filter));
+
+	uint64_t floors[2] = { FATAL + 1, FATAL + 1 };
+
+	for (uint32_t i = 0; i < c->filter_count; i++)
+	{
+		const config_filter* filter = &c->filters[i];
+
+		if (filter->kind == FILTER_LEVEL && filter->value < floors[filter->sink])
+		{
+			floors[filter->sink] = filter->value;
+		}
+	}
+
+	i_ae_atomic_store(&s_filters, (uint64_t)(uintptr_t)f);
+	i_ae_atomic_add(&s_generation, 1);
+
+	i_ae_atomic_store(&s_floors[AE_CONFIG_CONSOLE], floors[AE_CONFIG_CONSOLE]);
+	i_ae_atomic_store(&s_floors[AE_CONFIG_FILE], floors[AE_CONFIG_FILE]);
+
+	i_ae_log_console_floor_update();
+	i_ae_log_file_floor_update();
+
+	return 1;
+}
+
+// Parsing ------------------------------------------------------------------------------------------------------
+
+static int text_equal(const char* a, const char* b)
+{
+	for (; *a && *b; a++, b++)
+	{
+		char x = *a >= 'A' && *a <= 'Z' ? (char)(*a + 32) : *a;
+		char y = *b >= 'A' && *b <= 'Z' ? (char)(*b + 32) : *b;
+
+		if (x != y)
+		{
+			return 0;
+		}
+	}
+
+	return *a == *b;
+}
+
+static char* text_trim(char* s)
+{
+	while (*s == ' ' || *s == '\t')
+	{
+		s++;
+	}
+
+	char* end = s + strlen(s);
+
+	while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+	{
+		*--end = '\0';
+	}
+
+	return s;
+}
+
+/// <summary>
+/// Splits the first word off a value and returns the rest of it.
+/// </summary>
+static char* text_split(char* s)
+{
+	while (*s && *s != ' ' && *s != '\t')
+	{
+		s++;
+	}
+
+	if (*s)
+	{
+		*s++ = '\0';
+	}
+
+	return text_trim(s);
+}
+
+static int parse_level(const char* s)
+{
+	for (int i = 0; i < 5; i++)
+	{
+		if (text_equal(s, s_labels[i]))
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static int64_t parse_number(const char* s)
+{
+	char* end;
+	long long v = strtoll(s, &end, 10);
+
+	return (end == s || *end != '\0' || v < 0) ? -1 : (int64_t)v;
+}
+
+static int parse_switch(const char* s)
+{
+	if (text_equal(s, "on") || text_equal(s, "1"))
+	{
+		return 1;
+	}
+
+	return text_equal(s, "off") || text_equal(s, "0") ? 0 : -1;
+}
+
+static int parse_path(char* out, const char* s)
+{
+	int len = sprintf_s(out, AE_LOG_CONFIG_PATH_SIZE, "%s", s);
+	return len > 0 && len < AE_LOG_CONFIG_PATH_SIZE;
+}
+
+/// <summary>
+/// Parses '[pattern] [setting]' where the pattern may end with ':[line]' to match a single callsite.
+/// </summary>
+static int parse_filter(config_settings* c, int sink, int kind, char* value)
+{
+	char* setting = text_split(value);
+
+	if (c->filter_count == AE_LOG_CONFIG_MAX_FILTERS)
+	{
+		return 0;
+	}
+
+	config_filter* f = &c->filters[c->filter_count++];
+	f->sink = sink;
+	f->kind = kind;
+	f->line = 0;
+
+	if (kind == FILTER_LEVEL)
+	{
+		int l = parse_level(setting);
+		f->value = (uint32_t)l;
+
+		if (l < 0)
+		{
+			return 0;
+		}
+	}
+
+	else
+	{
+		int64_t rate = parse_number(setting);
+		f->value = (uint32_t)rate;
+
+		if (rate < 1 || rate > UINT32_MAX)
+		{
+			return 0;
+		}
+	}
+
+	char* colon = strrchr(value, ':');
+
+	if (colon && colon[1] >= '0' && colon[1] <= '9')
+	{
+		int64_t line = parse_number(colon + 1);
+		f->line = (int)line;
+		*colon = '\0';
+
+		if (line < 1 || line > INT32_MAX)
+		{
+			return 0;
+		}
+	}
+
+	return parse_path(f->pattern, value);
+}
+
+/// <summary>
+/// Parses one setting and returns 0 if the key is unknown or the value is invalid.
+/// </summary>
+static int parse_setting(config_settings* c, const char* key, char* value)
+{
+	if (text_equal(key, "console.level"))
+	{
+		return (c->console_level = parse_level(value)) >= 0;
+	}
+
+	else if (text_equal(key, "file.level"))
+	{
+		return (c->file_level = parse_level(value)) >= 0;
+	}
+
+	else if (text_equal(key, "console.filter"))
+	{
+		return parse_filter(c, AE_CONFIG_CONSOLE, FILTER_LEVEL, value);
+	}
+
+	else if (text_equal(key, "console.sample"))
+	{
+		return parse_filter(c, AE_CONFIG_CONSOLE, FILTER_RATE, value);
+	}
+
+	else if (text_equal(key, "file.filter"))
+	{
+		return parse_filter(c, AE_CONFIG_FILE, FILTER_LEVEL, value);
+	}
+
+	else if (text_equal(key, "file.sample"))
+	{
+		return parse_filter(c, AE_CONFIG_FILE, FILTER_RATE, value);
+	}
+
+	else if (text_equal(key, "file.format"))
+	{
+		c->file_format = text_equal(value, "text") ? AE_LOG_FILE_TEXT : text_equal(value, "json") ? AE_LOG_FILE_JSON : -1;
+		return c->file_format >= 0;
+	}
+
+	else if (text_equal(key, "file.reserve"))
+	{
+		return (c->file_reserve = parse_number(value)) >= 0;
+	}
+
+	else if (text_equal(key, "stats.sample"))
+	{
+		return (c->stats_sample = parse_number(value)) >= 0;
+	}
+
+	else if (text_equal(key, "stats.report"))
+	{
+		return (c->stats_report = parse_number(value)) >= 0;
+	}
+
+	else if (text_equal(key, "timer.report"))
+	{
+		return (c->timer_report = parse_number(value)) >= 0;
+	}
+
+	else if (text_equal(key, "trace"))
+	{
+		return parse_path(c->trace, value);
+	}
+
+	else if (text_equal(key, "socket"))
+	{
+		char* format = text_split(value);
+		c->socket_format = !*format || text_equal(format, "plain") ? AE_LOG_SOCKET_PLAIN : text_equal(format, "syslog") ? AE_LOG_SOCKET_SYSLOG : -1;
+
+		return c->socket_format >= 0 && parse_path(c->socket, value);
+	}
+
+	else if (text_equal(key, "shm"))
+	{
+		char* slots = text_split(value);
+		c->shm_slots = *slots ? parse_number(slots) : 0;
+
+		return c->shm_slots >= 0 && parse_path(c->shm, value);
+	}
+
+	else if (text_equal(key, "async"))
+	{
+		return (c->async = parse_switch(value)) >= 0;
+	}
+
+	else if (text_equal(key, "async.threads") || text_equal(key, "async.buffer_size") || text_equal(key, "async.reorder_window")
+		|| text_equal(key, "async.flush_size") || text_equal(key, "async.flush_latency") || text_equal(key, "async.idle_spin"))
+	{
+		int64_t v = parse_number(value);
+		uint32_t* field = text_equal(key, "async.threads") ? &c->async_config.max_threads
+			: text_equal(key, "async.buffer_size") ? &c->async_config.buffer_size
+			: text_equal(key, "async.reorder_window") ? &c->async_config.reorder_window
+			: text_equal(key, "async.flush_size") ? &c->async_config.flush_size
+			: text_equal(key, "async.flush_latency") ? &c->async_config.flush_latency : &c->async_config.idle_spin;
+
+		*field = (uint32_t)v;
+		return v >= 0 && v <= UINT32_MAX;
+	}
+
+	else if (text_equal(key, "async.drop_when_full"))
+	{
+		return (c->async_config.drop_when_full = parse_switch(value)) >= 0;
+	}
+
+	else if (text_equal(key, "async.priority"))
+	{
+		int level = text_equal(value, "off") ? TRACE : parse_level(value);
+		c->async_config.priority_level = level >= 0 ? (log_level)level : TRACE;
+
+		return level >= 0;
+	}
+
+	else if (text_equal(key, "memory.huge_pages"))
+	{
+		c->memory_huge_pages = text_equal(value, "off") ? AE_LOG_HUGE_PAGES_OFF : text_equal(value, "transparent") ? AE_LOG_HUGE_PAGES_TRANSPARENT
+			: text_equal(value, "explicit") ? AE_LOG_HUGE_PAGES_EXPLICIT : -1;
+		return c->memory_huge_pages >= 0;
+	}
+
+	else if (text_equal(key, "memory.numa"))
+	{
+		return (c->memory_numa = parse_switch(value)) >= 0;
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Reads and parses a configuration file. Returns 0 and logs the first invalid line if it can not be used.
+/// </summary>
+static int config_parse(const char* path, config_settings* c)
+{
+	memset(c, 0, sizeof(config_settings));
+
+	c->console_level = -1;
+	c->file_level = -1;
+	c->file_format = -1;
+	c->file_reserve = -1;
+	c->stats_sample = -1;
+	c->stats_report = -1;
+	c->timer_report = -1;
+	c->socket_format = -1;
+	c->async = -1;
+	c->async_config = (ae_log_async_config){ 64, 1 << 20, 10000, 0, ERROR, 64 << 10, 20000, 50 };
+	c->memory_huge_pages = -1;
+	c->memory_numa = -1;
+
+	FILE* f;
+	fopen_s(&f, path, "rb");
+
+	if (!f)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to load logging configuration '%s' because the file could not be opened.", path);
+		return 0;
+	}
+
+	char* text = malloc(AE_LOG_CONFIG_MAX_SIZE + 1);
+
+	if (!text)
+	{
+		fclose(f);
+		return 0;
+	}
+
+	size_t size = fread(text, 1, AE_LOG_CONFIG_MAX_SIZE + 1, f);
+	fclose(f);
+
+	if (size > AE_LOG_CONFIG_MAX_SIZE)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to load logging configuration '%s' because it is larger than %d bytes.", path, AE_LOG_CONFIG_MAX_SIZE);
+
+		free(text);
+		return 0;
+	}
+
+	text[size] = '\0';
+
+	char* line = text;
+	int number = 1;
+	int valid = 1;
+
+	while (line && valid)
+	{
+		char* next = strchr(line, '\n');
+
+		if (next)
+		{
+			*next++ = '\0';
+		}
+
+		char* key = text_trim(line);
+
+		if (*key && *key != '#')
+		{
+			char* value = strchr(key, '=');
+
+			if (value)
+			{
+				*value++ = '\0';
+				valid = parse_setting(c, text_trim(key), text_trim(value));
+			}
+
+			else
+			{
+				valid = 0;
+			}
+
+			if (!valid)
+			{
+				AE_LOG_CONSOLE_ERROR("Failed to load logging configuration '%s' because line %d is invalid.", path, number);
+			}
+		}
+
+		line = next;
+		number++;
+	}
+
+	free(text);
+	return valid;
+}
+
+// Applying -----------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Applies parsed settings. Levels and filters take effect for the next message of every thread, sinks are
+/// only reopened if they changed. The ring and asynchronous logging are only set up by the first load since
+/// logging threads may be using them. Must be called with s_mutex locked.
+/// </summary>
+static int config_apply(const config_settings* c, const char* path)
+{
+	if (!filters_publish(c))
+	{
+		return 0;
+	}
+
+	if (c->console_level >= 0)
+	{
+		ae_log_console_level_set((log_level)c->console_level);
+	}
+
+	if (c->file_level >= 0)
+	{
+		ae_log_file_level_set((log_level)c->file_level);
+	}
+
+	if (c->file_format >= 0)
+	{
+		ae_log_file_format_set((ae_log_file_format)c->file_format);
+	}
+
+	if (c->stats_sample >= 0)
+	{
+		ae_log_stats_sample_set((uint32_t)c->stats_sample);
+	}
+
+	if (c->stats_report >= 0)
+	{
+		ae_log_stats_report_set((uint32_t)c->stats_report);
+	}
+
+	if (c->timer_report >= 0)
+	{
+		ae_log_timer_report_set((uint32_t)c->timer_report);
+	}
+
+	if (strcmp(c->trace, s_applied.trace) != 0)
+	{
+		if (!*c->trace || text_equal(c->trace, "off"))
+		{
+			ae_log_trace_close();
+		}
+
+		else
+		{
+			ae_log_trace_open(c->trace);
+		}
+	}
+
+	if (strcmp(c->socket, s_applied.socket) != 0 || c->socket_format != s_applied.socket_format)
+	{
+		if (!*c->socket || text_equal(c->socket, "off"))
+		{
+			ae_log_socket_close();
+		}
+
+		else
+		{
+			ae_log_socket_open(c->socket, (ae_log_socket_format)c->socket_format);
+		}
+	}
+
+	if (!s_loaded)
+	{
+		// The memory policy is set first since it applies to the reserved memory and the buffers
+		if (c->memory_huge_pages >= 0 || c->memory_numa >= 0)
+		{
+			ae_log_memory_config memory;
+			ae_log_memory_get(&memory);
+
+			memory.huge_pages = c->memory_huge_pages >= 0 ? (ae_log_huge_pages)c->memory_huge_pages : memory.huge_pages;
+			memory.numa_local = c->memory_numa >= 0 ? c->memory_numa : memory.numa_local;
+
+			ae_log_memory_set(&memory);
+		}
+
+		if (c->file_reserve > 0)
+		{
+			ae_log_file_reserve((uint64_t)c->file_reserve);
+		}
+
+		if (*c->shm && !text_equal(c->shm, "off"))
+		{
+			ae_log_shm_open(c->shm, (uint32_t)c->shm_slots);
+		}
+
+		if (c->async == 1)
+		{
+			ae_log_file_async_start(&c->async_config);
+		}
+
+		// The policy is read back since huge pages may not have been available
+		if (c->memory_huge_pages >= 0 || c->memory_numa >= 0)
+		{
+			const char* names[3] = { "normal pages", "transparent huge pages", "explicit huge pages" };
+
+			ae_log_memory_config memory;
+			ae_log_memory_get(&memory);
+
+			AE_LOG_CONSOLE_INFO("Log buffers use %s with NUMA placement %s.", names[memory.huge_pages], memory.numa_local ? "on" : "off");
+		}
+	}
+
+	else if (strcmp(c->shm, s_applied.shm) != 0 || c->shm_slots != s_applied.shm_slots || c->async != s_applied.async
+		|| memcmp(&c->async_config, &s_applied.async_config, sizeof(ae_log_async_config)) != 0 || c->file_reserve != s_applied.file_reserve
+		|| c->memory_huge_pages != s_applied.memory_huge_pages || c->memory_numa != s_applied.memory_numa)
+	{
+		AE_LOG_CONSOLE_WARNING("The shared-memory ring, asynchronous logging, reserved memory and memory policy in '%s' are only applied when the process starts.", path);
+	}
+
+	// Settings that only apply on the first load are kept as loaded so that the warning is not repeated
+	config_settings applied = *c;
+
+	if (s_loaded)
+	{
+		memcpy(applied.shm, s_applied.shm, sizeof(applied.shm));
+		applied.shm_slots = s_applied.shm_slots;
+		applied.async = s_applied.async;
+		applied.async_config = s_applied.async_config;
+		applied.file_reserve = s_applied.file_reserve;
+		applied.memory_huge_pages = s_applied.memory_huge_pages;
+		applied.memory_numa = s_applied.memory_numa;
+	}
+
+	s_applied = applied;
+	s_loaded = 1;
+
+	return 1;
+}
+
+/// <summary>
+/// Parses and applies a configuration file. Must be called with s_mutex locked.
+/// </summary>
+static int config_load(const char* path)
+{
+	// Kept static since the settings are too large for the stack of the watcher on some platforms
+	static config_settings c;
+
+	return config_parse(path, &c) && config_apply(&c, path);
+}
+
+// Watcher ------------------------------------------------------------------------------------------------------
+
+#ifdef AE_LINUX
+
+/// <summary>
+/// Waits for the configuration file to change. The directory is watched since editors often replace the file
+/// instead of writing to it. Returns 1 if the file changed.
+/// </summary>
+static int watch_wait(int fd, const char* name)
+{
+	struct pollfd p = { fd, POLLIN, 0 };
+
+	if (poll(&p, 1, AE_LOG_CONFIG_POLL_INTERVAL) <= 0)
+	{
+		return 0;
+	}
+
+	char events[4096] AE_ALIGN(8);
+	ssize_t size = read(fd, events, sizeof(events));
+	int changed = 0;
+
+	for (ssize_t i = 0; i < size;)
+	{
+		const struct inotify_event* e = (const struct inotify_event*)(events + i);
+
+		if (e->len > 0 && strcmp(e->name, name) == 0)
+		{
+			changed = 1;
+		}
+
+		i += (ssize_t)(sizeof(struct inotify_event) + e->len);
+	}
+
+	return changed;
+}
+
+I_AE_THREAD_FUNCTION(watcher_main, arg)
+{
+	int fd = (int)(intptr_t)arg;
+
+	const char* slash = strrchr(s_path, '/');
+	const char* name = slash ? slash + 1 : s_path;
+
+	while (i_ae_atomic_load(&s_watching))
+	{
+		if (watch_wait(fd, name))
+		{
+			i_ae_mutex_lock(&s_mutex);
+
+			if (config_load(s_path))
+			{
+				AE_LOG_CONSOLE_INFO("Applied logging configuration '%s'.", s_path);
+			}
+
+			i_ae_mutex_unlock(&s_mutex);
+		}
+	}
+
+	close(fd);
+	I_AE_THREAD_RETURN;
+}
+
+static int watch_start(void)
+{
+	char directory[AE_LOG_CONFIG_PATH_SIZE];
+	const char* slash = strrchr(s_path, '/');
+
+	if (slash)
+	{
+		sprintf_s(directory, sizeof(directory), "%.*s", (int)(slash - s_path) + (slash == s_path), s_path);
+	}
+
+	else
+	{
+		sprintf_s(directory, sizeof(directory), ".");
+	}
+
+	int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (fd < 0 || inotify_add_watch(fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+
+		return 0;
+	}
+
+	if (!i_ae_thread_create(&s_watcher, watcher_main, (void*)(intptr_t)fd))
+	{
+		close(fd);
+		return 0;
+	}
+
+	return 1;
+}
+
+#else
+
+#ifdef AE_WINDOWS
+#define stat _stat64
+#define config_stat(p, s) _stat64(p, s)
+#else
+#define config_stat(p, s) stat(p, s)
+#endif // AE_WINDOWS
+
+/// <summary>
+/// Returns a value that changes when the configuration file is written, or 0 if it does not exist.
+/// </summary>
+static uint64_t watch_version(void)
+{
+	struct stat st;
+
+	if (config_stat(s_path, &st) != 0)
+	{
+		return 0;
+	}
+
+	return (uint64_t)st.st_mtime * 1000003ULL + (uint64_t)st.st_size;
+}
+
+I_AE_THREAD_FUNCTION(watcher_main, arg)
+{
+	(void)arg;
+
+	uint64_t version = watch_version();
+
+	// Without inotify the modification time is polled
+	while (i_ae_atomic_load(&s_watching))
+	{
+		i_ae_sleep_us(AE_LOG_CONFIG_POLL_INTERVAL * 1000);
+
+		uint64_t current = watch_version();
+
+		if (current != 0 && current != version)
+		{
+			version = current;
+
+			i_ae_mutex_lock(&s_mutex);
+
+			if (config_load(s_path))
+			{
+				AE_LOG_CONSOLE_INFO("Applied logging configuration '%s'.", s_path);
+			}
+
+			i_ae_mutex_unlock(&s_mutex);
+		}
+	}
+
+	I_AE_THREAD_RETURN;
+}
+
+static int watch_start(void)
+{
+	return i_ae_thread_create(&s_watcher, watcher_main, NULL);
+}
+
+#endif // AE_LINUX
+
+// Interface ----------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Returns the path to load, which is the AE_LOG_CONFIG environment variable if no path is specified.
+/// </summary>
+static const char* config_path(const char* path)
+{
+	if (path)
+	{
+		return path;
+	}
+
+	path = getenv("AE_LOG_CONFIG");
+
+	if (!path || !*path)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to load logging configuration because no path was specified and AE_LOG_CONFIG is not set.");
+		return NULL;
+	}
+
+	return path;
+}
+
+int ae_log_config_load(const char* path)
+{
+	path = config_path(path);
+
+	if (!path)
+	{
+		return 0;
+	}
+
+	i_ae_mutex_lock(&s_mutex);
+	int loaded = config_load(path);
+	i_ae_mutex_unlock(&s_mutex);
+
+	return loaded;
+}
+
+int ae_log_config_watch(const char* path)
+{
+	ae_log_config_unwatch();
+
+	path = config_path(path);
+
+	if (!path)
+	{
+		return 0;
+	}
+
+	if (!parse_path(s_path, path))
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to watch logging configuration because the path is longer than %d characters.", AE_LOG_CONFIG_PATH_SIZE - 1);
+		return 0;
+	}
+
+	if (!ae_log_config_load(s_path))
+	{
+		return 0;
+	}
+
+	i_ae_atomic_store(&s_watching, 1);
+
+	if (!watch_start())
+	{
+		i_ae_atomic_store(&s_watching, 0);
+
+		AE_LOG_CONSOLE_ERROR("Failed to watch logging configuration '%s' because the watcher could not be started.", s_path);
+		return 0;
+	}
+
+	return 1;
+}
+
+void ae_log_config_unwatch(void)
+{
+	if (!i_ae_atomic_exchange(&s_watching, 0))
+	{
+		return;
+	}
+
+	i_ae_thread_join(s_watcher);
+}
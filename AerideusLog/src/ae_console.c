@@ -1,46 +1,172 @@
 /*
 	Author: @rasmushugosson
-	Last modified: 2023-03-20
+	Last modified: 2026-10-18
 */
 
 #include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
 
 #include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 
-#ifdef AE_WINDOWS
-
-#include <Windows.h>
+// Read by every logging thread and changed at any time, for example by the configuration watcher
+static volatile uint64_t s_level = TRACE;
+static i_ae_mutex s_floor_mutex = I_AE_MUTEX_INIT;
 
-#endif // AE_WINDOWS
-
-static log_level s_level = TRACE;
+volatile uint64_t i_ae_log_console_floor = TRACE;
 
 void ae_log_console_level_set(log_level min)
 {
-	s_level = min;
+	i_ae_atomic_store_relaxed(&s_level, (uint64_t)min);
+	i_ae_log_console_floor_update();
+}
+
+void i_ae_log_console_floor_update(void)
+{
+	// Serialized so that the floor is always computed from the latest level and filters
+	i_ae_mutex_lock(&s_floor_mutex);
+
+	log_level floor = i_ae_config_floor(AE_CONFIG_CONSOLE, (log_level)i_ae_atomic_load_relaxed(&s_level));
+	i_ae_atomic_store_relaxed(&i_ae_log_console_floor, (uint64_t)floor);
+
+	i_ae_mutex_unlock(&s_floor_mutex);
 }
 
+// Lines of at most this length are written to the console with a single call
+#define AE_LOG_CONSOLE_BUFFER_SIZE 2048
+
+#ifdef AE_WINDOWS
 static WORD s_colors[5] = { 8, 10, 14, 12, 12 };
-static const char* s_labels[5] = { "TRACE", "INFO", "WARNING", "ERROR", "FATAL" };
+#else
+static const char* s_colors[5] = { "\x1b[90m", "\x1b[92m", "\x1b[93m", "\x1b[91m", "\x1b[91m" };
+
+// 0 until checked, then 1 if colors are used or 2 if they are not
+static volatile uint64_t s_ansi = 0;
+#endif // AE_WINDOWS
+
+/// <summary>
+/// Returns the color sequence that starts a line, or an empty string if the console does not use them.
+/// </summary>
+static const char* console_color(log_level l)
+{
+#ifdef AE_WINDOWS
+	SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), s_colors[l]);
+	return "";
+#else
+	// Colors are left out when the output is redirected or NO_COLOR is set
+	if (s_ansi == 0)
+	{
+		i_ae_atomic_store(&s_ansi, isatty(fileno(stdout)) && !getenv("NO_COLOR") ? 1 : 2);
+	}
+
+	return s_ansi == 1 ? s_colors[l] : "";
+#endif // AE_WINDOWS
+}
+
+static void console_log(i_ae_callsite* s, uint32_t rate, log_level l, const char* fn, int ln, const char* f, va_list args)
+{
+	i_ae_stats_add(AE_STATS_CONSOLE + l, 1);
+
+	const char* color = console_color(l);
+
+	// Sampled lines note the rate after the message
+	char suffix[48];
+	int suffix_length = rate > 1 ? sprintf_s(suffix, sizeof(suffix), "' | Sampled: 1/%u%s\n", rate, color[0] ? "\x1b[0m" : "")
+		: sprintf_s(suffix, sizeof(suffix), "'%s\n", color[0] ? "\x1b[0m" : "");
+
+	char line[AE_LOG_CONSOLE_BUFFER_SIZE];
+	uint64_t len;
+
+	const i_ae_callsite* site = s ? i_ae_callsite_prefix(s, l, color) : NULL;
+
+	if (site)
+	{
+		memcpy(line, site->prefix, site->length);
+		len = site->length;
+	}
+
+	else
+	{
+		// The prefix of a callsite is only uncached when it is too long for the callsite, so the whole line is used
+		len = i_ae_callsite_render(line, AE_LOG_CONSOLE_BUFFER_SIZE, color, l, fn, ln);
+	}
+
+	va_list copy;
+	va_copy(copy, args);
+
+	int n = vsnprintf(line + len, (size_t)(AE_LOG_CONSOLE_BUFFER_SIZE - len), f, args);
+
+	if (n >= 0 && len + (uint64_t)n + (uint64_t)suffix_length <= AE_LOG_CONSOLE_BUFFER_SIZE)
+	{
+		memcpy(line + len + n, suffix, (size_t)suffix_length);
+		fwrite(line, 1, (size_t)(len + (uint64_t)n + (uint64_t)suffix_length), stdout);
+	}
+
+	else
+	{
+		fwrite(line, 1, (size_t)len, stdout);
+		vprintf(f, copy);
+		fputs(suffix, stdout);
+	}
+
+	va_end(copy);
+}
 
 void i_ae_log_console(log_level l, const char* fn, int ln, const char* f, ...)
 {
-	if (l < s_level)
+	if ((uint64_t)l < i_ae_atomic_load_relaxed(&s_level))
 	{
 		return;
 	}
 
-#ifdef AE_WINDOWS
-	SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), s_colors[l]);
-#endif // AE_WINDOWS
+	va_list args;
+
+	va_start(args, f);
+	console_log(NULL, 0, l, fn, ln, f, args);
+	va_end(args);
+}
 
-	printf("[%s] %s | Line: %d | Message: '", s_labels[l], fn, ln);
+void i_ae_log_console_site(i_ae_callsite* s, log_level l, const char* f, ...)
+{
+	if (l < i_ae_config_level(s, AE_CONFIG_CONSOLE, (log_level)i_ae_atomic_load_relaxed(&s_level)))
+	{
+		return;
+	}
+
+	// Lines of code can also be sampled by the configuration, the decision is made before formatting
+	uint32_t rate = i_ae_config_rate(s, AE_CONFIG_CONSOLE, 0);
+
+	if (rate > 1 && !i_ae_callsite_hit(rate))
+	{
+		return;
+	}
 
 	va_list args;
 
 	va_start(args, f);
-	vprintf(f, args);
+	console_log(s, rate, l, s->file, s->line, f, args);
 	va_end(args);
+}
+
+uint32_t i_ae_log_console_sample(i_ae_callsite* s, uint32_t rate)
+{
+	rate = i_ae_config_rate(s, AE_CONFIG_CONSOLE, rate);
+	return rate <= 1 || i_ae_callsite_hit(rate) ? (rate ? rate : 1) : 0;
+}
 
-	printf("'\n");
+void i_ae_log_console_sampled(i_ae_callsite* s, uint32_t rate, log_level l, const char* f, ...)
+{
+	if (l < i_ae_config_level(s, AE_CONFIG_CONSOLE, (log_level)i_ae_atomic_load_relaxed(&s_level)))
+	{
+		return;
+	}
+
+	va_list args;
+
+	va_start(args, f);
+	console_log(s, rate, l, s->file, s->line, f, args);
+	va_end(args);
 }
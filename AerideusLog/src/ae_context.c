@@ -0,0 +1,151 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+
+#include <string.h>
+
+// Keys and values are encoded with their length in a single byte
+#define AE_LOG_CONTEXT_PART_SIZE 255
+
+const ae_log_context i_ae_context_none = { NULL, 0, { 0 } };
+
+// Encoding -----------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Encodes a key or value as its length followed by its bytes and returns the encoded length.
+/// </summary>
+static uint32_t context_part(char* out, const char* text, uint32_t length)
+{
+	out[0] = (char)(unsigned char)length;
+	memcpy(out + 1, text, length);
+
+	return length + 1;
+}
+
+/// <summary>
+/// Returns the length of a key or value, cut to the encoding and to the room left for it.
+/// </summary>
+static uint32_t context_length(const char* text, uint32_t room)
+{
+	uint32_t limit = room < AE_LOG_CONTEXT_PART_SIZE ? room : AE_LOG_CONTEXT_PART_SIZE;
+	return text ? (uint32_t)strnlen(text, limit) : 0;
+}
+
+// Rendering ----------------------------------------------------------------------------------------------------
+
+uint64_t i_ae_context_text(char* out, const char* context, uint64_t length)
+{
+	if (length == 0)
+	{
+		return 0;
+	}
+
+	memcpy(out, " | Context: ", 12);
+	uint64_t n = 12;
+
+	for (uint64_t i = 0; i < length;)
+	{
+		uint32_t key_length = (unsigned char)context[i];
+		uint32_t value_length = (unsigned char)context[i + 1 + key_length];
+
+		if (i > 0)
+		{
+			out[n++] = ' ';
+		}
+
+		memcpy(out + n, context + i + 1, key_length);
+		n += key_length;
+		out[n++] = '=';
+		memcpy(out + n, context + i + 2 + key_length, value_length);
+		n += value_length;
+
+		i += 2 + key_length + value_length;
+	}
+
+	return n;
+}
+
+uint64_t i_ae_context_json(char* out, const char* context, uint64_t length)
+{
+	if (length == 0)
+	{
+		return 0;
+	}
+
+	memcpy(out, ",\"context\":{", 12);
+	uint64_t n = 12;
+
+	for (uint64_t i = 0; i < length;)
+	{
+		uint32_t key_length = (unsigned char)context[i];
+		uint32_t value_length = (unsigned char)context[i + 1 + key_length];
+
+		if (i > 0)
+		{
+			out[n++] = ',';
+		}
+
+		out[n++] = '"';
+		n += i_ae_json_escape(out + n, context + i + 1, key_length);
+		memcpy(out + n, "\":\"", 3);
+		n += 3;
+		n += i_ae_json_escape(out + n, context + i + 2 + key_length, value_length);
+		out[n++] = '"';
+
+		i += 2 + key_length + value_length;
+	}
+
+	out[n++] = '}';
+	return n;
+}
+
+// Interface ----------------------------------------------------------------------------------------------------
+
+void ae_log_context_push(ae_log_context* c, const char* key, const char* value)
+{
+	i_ae_thread_info* t = i_ae_thread_info_get();
+	const ae_log_context* parent = t->context;
+
+	// The pairs below are copied once here so that records never have to walk the stack
+	memcpy(c->data, parent->data, parent->length);
+
+	c->parent = parent;
+	c->length = parent->length;
+
+	uint32_t room = AE_LOG_CONTEXT_SIZE - c->length;
+	uint32_t key_length = context_length(key, room > 2 ? room - 2 : 0);
+
+	if (key_length > 0)
+	{
+		value = value ? value : "";
+		uint32_t value_length = context_length(value, room - 2 - key_length);
+
+		c->length += context_part(c->data + c->length, key, key_length);
+		c->length += context_part(c->data + c->length, value, value_length);
+	}
+
+	t->context = c;
+}
+
+void ae_log_context_pop(ae_log_context* c)
+{
+	i_ae_thread_info_get()->context = c->parent;
+}
+
+const ae_log_context* ae_log_context_current(void)
+{
+	return i_ae_thread_info_get()->context;
+}
+
+const ae_log_context* ae_log_context_swap(const ae_log_context* c)
+{
+	i_ae_thread_info* t = i_ae_thread_info_get();
+	const ae_log_context* previous = t->context;
+
+	t->context = c ? c : &i_ae_context_none;
+	return previous;
+}
@@ -1,164 +1,1073 @@
 /*
 	Author: @rasmushugosson
-	Last modified: 2023-03-22
+	Last modified: 2026-10-18
 */
 
 #include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
 
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
-#include <memory.h>
+#include <string.h>
 
-#ifdef AE_WINDOWS
-#include <Windows.h>
-#endif // AE_WINDOWS
+// Read by every logging thread and changed at any time, for example by the configuration watcher
+static volatile uint64_t s_level = TRACE;
+static i_ae_mutex s_floor_mutex = I_AE_MUTEX_INIT;
 
-static log_level s_level = TRACE;
+volatile uint64_t i_ae_log_file_floor = TRACE;
 
 void ae_log_file_level_set(log_level min)
 {
-	s_level = min;
+	i_ae_atomic_store_relaxed(&s_level, (uint64_t)min);
+	i_ae_log_file_floor_update();
 }
 
-#define AE_LOG_FILE_BUFFER_SIZE 1024
+void i_ae_log_file_floor_update(void)
+{
+	// Serialized so that the floor is always computed from the latest level and filters
+	i_ae_mutex_lock(&s_floor_mutex);
+
+	log_level floor = i_ae_config_floor(AE_CONFIG_FILE, (log_level)i_ae_atomic_load_relaxed(&s_level));
+	i_ae_atomic_store_relaxed(&i_ae_log_file_floor, (uint64_t)floor);
+
+	i_ae_mutex_unlock(&s_floor_mutex);
+}
+
+// Messages are escaped for JSON in blocks of this many bytes
+#define AE_LOG_FILE_JSON_BLOCK 512
+
+// Length of ' | Message: '', which ends the start of every line in the text format
+#define AE_LOG_FILE_MESSAGE_START 13
+
+// Room for the start of a line before the context and the message, which is cut to fit
+#define AE_LOG_FILE_HEAD_SIZE (AE_LOG_FILE_BUFFER_SIZE - I_AE_CONTEXT_TEXT_SIZE - AE_LOG_FILE_MESSAGE_START)
 
-static char* s_file_data = NULL;
+// Room for the end of a line, which notes the thread, its sequence number and the sample rate of sampled records
+#define AE_LOG_FILE_SUFFIX_SIZE 256
+
+// The log file is kept in memory as a list of chunks until it is exported
+#define AE_LOG_FILE_CHUNK_SIZE 65536
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+
+static ae_file_chunk* s_first = NULL;
+static ae_file_chunk* s_last = NULL;
+static ae_file_chunk* s_current = NULL;
 static uint64_t s_file_size = 0;
-static char s_message_buffer[AE_LOG_FILE_BUFFER_SIZE];
+static uint64_t s_file_capacity = 0;
+
+// Every byte that has been added to the log file, including bytes that have since been streamed
+static volatile uint64_t s_file_total = 0;
+
+static ae_log_file_format s_format = AE_LOG_FILE_TEXT;
+static ae_log_hex_format s_hex_format = AE_LOG_HEX_INLINE;
+
+// A message and a chunk of bytes as a 'hexdump -C' of 80 characters per 16 bytes, with room for the range
+static char s_hex_buffer[AE_LOG_FILE_BUFFER_SIZE + 128 + AE_LOG_HEX_CHUNK_SIZE / 16 * 80];
+
+static ae_file_chunk* s_pool = NULL;
+static uint64_t s_chunk_count = 0;
+static uint64_t s_reserved_count = 0;
+
+/// <summary>
+/// Memory that reserved chunks are carved from. Arenas are allocated with the memory policy and kept for the
+/// life of the process, their chunks are always returned to the pool.
+/// </summary>
+typedef struct file_arena
+{
+	struct file_arena* next;
+	char* data;
+	uint64_t size;
+	int memory;
+} file_arena;
+
+static file_arena* s_arenas = NULL;
+
+static AE_THREAD_LOCAL char t_message_buffer[AE_LOG_FILE_BUFFER_SIZE];
 
 static const char* s_labels[5] = { "TRACE", "INFO", "WARNING", "ERROR", "FATAL" };
 
-void i_ae_log_file(log_level l, const char* fn, int ln, const char* f, ...)
+// Storage ------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Takes a chunk from the pool, or allocates one if the pool is empty. Must be called with s_mutex locked.
+/// </summary>
+static ae_file_chunk* chunk_take(void)
 {
-	if (l < s_level)
+	ae_file_chunk* c = s_pool;
+
+	if (c)
 	{
-		return;
+		s_pool = c->next;
+	}
+
+	else
+	{
+		c = malloc(sizeof(ae_file_chunk) + AE_LOG_FILE_CHUNK_SIZE);
+
+		if (!c)
+		{
+			return NULL;
+		}
+
+		s_chunk_count++;
 	}
 
-	sprintf_s(s_message_buffer, AE_LOG_FILE_BUFFER_SIZE, "[%s] %s | Line: %d | Message: '", s_labels[l], fn, ln);
+	c->next = NULL;
+	c->size = 0;
+	c->capacity = AE_LOG_FILE_CHUNK_SIZE;
+	c->pooled = 1;
 
-	uint64_t len = 0;
+	return c;
+}
 
-	for (int i = 0; i < AE_LOG_FILE_BUFFER_SIZE; i++)
+static int chunk_in_arena(const ae_file_chunk* c)
+{
+	for (file_arena* a = s_arenas; a; a = a->next)
 	{
-		if (s_message_buffer[i] == '\0')
+		if ((const char*)c >= a->data && (const char*)c < a->data + a->size)
 		{
-			len = i;
-			break;
+			return 1;
 		}
 	}
 
-	if (s_file_size == 0)
+	return 0;
+}
+
+/// <summary>
+/// Returns chunks to the pool. Chunks beyond the reserved number are freed. Must be called with s_mutex locked.
+/// </summary>
+static void chunks_return(ae_file_chunk* c)
+{
+	while (c)
 	{
-		s_file_size = len;
-		s_file_data = malloc(s_file_size + 1);
+		ae_file_chunk* next = c->next;
+
+		// A chunk of a long message can have the size of a pooled chunk, so it is told apart by the flag
+		if (!c->pooled)
+		{
+			free(c);
+		}
+
+		else if (s_chunk_count > s_reserved_count && !chunk_in_arena(c))
+		{
+			free(c);
+			s_chunk_count--;
+		}
 
-		memcpy(s_file_data, s_message_buffer, len);
+		else
+		{
+			c->next = s_pool;
+			s_pool = c;
+		}
+
+		c = next;
 	}
+}
 
-	else
+/// <summary>
+/// Makes sure that the specified number of bytes can be added to the log file without running out of memory
+/// halfway. Returns 0 if the memory could not be allocated. Must be called with s_mutex locked.
+/// </summary>
+static int file_ensure(uint64_t len)
+{
+	while (s_file_capacity < len)
 	{
-		char* data = realloc(s_file_data, s_file_size + len + 1);
+		ae_file_chunk* c = chunk_take();
 
-		if (data)
+		if (!c)
 		{
-			s_file_data = data;
+			return 0;
+		}
 
-			memcpy(s_file_data + s_file_size, s_message_buffer, len);
-			s_file_size += len;
-			s_file_data[s_file_size] = '\0';
+		if (s_last)
+		{
+			s_last->next = c;
+		}
+
+		else
+		{
+			s_first = c;
+			s_current = c;
 		}
+
+		s_last = c;
+		s_file_capacity += AE_LOG_FILE_CHUNK_SIZE;
 	}
 
-	va_list args;
+	return 1;
+}
 
-	va_start(args, f);
-	vsnprintf_s(s_message_buffer, AE_LOG_FILE_BUFFER_SIZE, AE_LOG_FILE_BUFFER_SIZE, f, args);
-	va_end(args);
+/// <summary>
+/// Adds bytes to the log file. Space must first be made with file_ensure(). Must be called with s_mutex locked.
+/// </summary>
+static void file_append(const char* data, uint64_t len)
+{
+	while (len > 0)
+	{
+		uint64_t room = s_current->capacity - s_current->size;
+
+		if (room == 0)
+		{
+			s_current = s_current->next;
+			continue;
+		}
+
+		uint64_t n = len < room ? len : room;
+		memcpy(s_current->data + s_current->size, data, (size_t)n);
 
-	len = 0;
+		s_current->size += n;
+		s_file_size += n;
+		s_file_capacity -= n;
 
-	for (int i = 0; i < AE_LOG_FILE_BUFFER_SIZE; i++)
+		i_ae_atomic_store_relaxed(&s_file_total, s_file_total + n);
+
+		data += n;
+		len -= n;
+	}
+}
+
+/// <summary>
+/// Adds a filled chunk to the log file after the chunk that is being written. The rest of that chunk is left
+/// unused, while the rest of the added chunk is written next. Must be called with s_mutex locked.
+/// </summary>
+static void file_insert(ae_file_chunk* c)
+{
+	if (s_current)
 	{
-		if (s_message_buffer[i] == '\0')
+		s_file_capacity -= s_current->capacity - s_current->size;
+
+		c->next = s_current->next;
+		s_current->next = c;
+
+		if (s_last == s_current)
 		{
-			len = (uint64_t)i + 2;
-			break;
+			s_last = c;
 		}
 	}
 
-	char* data = realloc(s_file_data, s_file_size + len + 1);
+	else
+	{
+		c->next = NULL;
+
+		s_first = c;
+		s_last = c;
+	}
+
+	s_current = c;
+	s_file_size += c->size;
+	s_file_capacity += c->capacity - c->size;
+
+	i_ae_atomic_store_relaxed(&s_file_total, s_file_total + c->size);
+}
+
+/// <summary>
+/// Renders a number in decimal and returns its length. Used instead of sprintf for the numbers of every line.
+/// </summary>
+static uint64_t file_number(char* out, uint64_t v)
+{
+	char digits[20];
+	uint64_t n = 0;
+
+	do
+	{
+		digits[n++] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v > 0);
+
+	for (uint64_t i = 0; i < n; i++)
+	{
+		out[i] = digits[n - 1 - i];
+	}
+
+	return n;
+}
+
+static uint64_t file_text(char* out, const char* text, uint64_t length)
+{
+	memcpy(out, text, (size_t)length);
+	return length;
+}
+
+/// <summary>
+/// Renders the start of a line in the text format and returns its length. The context of the record is
+/// inserted before the message.
+/// </summary>
+static uint64_t file_prefix(const ae_record* r, const char* time, char* prefix)
+{
+	uint64_t len;
 
-	if (data)
+	// The part after the time is copied from the callsite when it has already been rendered
+	if (r->site)
 	{
-		s_file_data = data;
+		uint64_t time_len = strlen(time);
+
+		memcpy(prefix, time, (size_t)time_len);
+		prefix[time_len] = ' ';
+
+		if (r->context_length == 0)
+		{
+			memcpy(prefix + time_len + 1, r->site->prefix, r->site->length);
+			return time_len + 1 + r->site->length;
+		}
 
-		memcpy(s_file_data + s_file_size, s_message_buffer, len - 2);
-		s_file_size += len;
-		s_file_data[s_file_size - 2] = '\'';
-		s_file_data[s_file_size - 1] = '\n';
-		s_file_data[s_file_size] = '\0';
+		len = time_len + 1 + file_text(prefix + time_len + 1, r->site->prefix, r->site->length - AE_LOG_FILE_MESSAGE_START);
 	}
+
+	else
+	{
+		int n = sprintf_s(prefix, AE_LOG_FILE_HEAD_SIZE, "%s [%s] %s | Line: %d", time, s_labels[r->level], r->file, r->line);
+
+		len = n < 0 ? 0 : (uint64_t)n;
+		len = len < AE_LOG_FILE_HEAD_SIZE ? len : AE_LOG_FILE_HEAD_SIZE - 1;
+	}
+
+	len += i_ae_context_text(prefix + len, r->context, r->context_length);
+	return len + file_text(prefix + len, " | Message: '", AE_LOG_FILE_MESSAGE_START);
 }
 
-void i_ae_log_file_next_line()
+/// <summary>
+/// Renders the end of a line in the text format, with the thread and sequence number of the record and the
+/// sample rate if the record was sampled, and returns its length.
+/// </summary>
+static uint64_t file_suffix(const ae_record* r, char* suffix)
 {
-	if (s_file_size == 0)
+	uint64_t n = file_text(suffix, "'", 1);
+
+	if (r->thread)
 	{
+		n += file_text(suffix + n, " | Thread: ", 11);
+
+		if (r->thread_name[0])
+		{
+			n += file_text(suffix + n, r->thread_name, strnlen(r->thread_name, AE_LOG_THREAD_NAME_SIZE - 1));
+			n += file_text(suffix + n, " (", 2);
+			n += file_number(suffix + n, r->thread);
+			n += file_text(suffix + n, ")", 1);
+		}
+
+		else
+		{
+			n += file_number(suffix + n, r->thread);
+		}
+
+		n += file_text(suffix + n, " | Sequence: ", 13);
+		n += file_number(suffix + n, r->sequence);
+	}
+
+	if (r->rate > 1)
+	{
+		n += file_text(suffix + n, " | Sampled: 1/", 14);
+		n += file_number(suffix + n, r->rate);
+	}
+
+	return n + file_text(suffix + n, "\n", 1);
+}
+
+/// <summary>
+/// Renders the end of a JSON line, which closes the message and adds the thread, its sequence number, the
+/// sample rate if the record was sampled and the context, and returns its length.
+/// </summary>
+static uint64_t file_suffix_json(const ae_record* r, char* suffix)
+{
+	uint64_t n = file_text(suffix, "\"", 1);
+
+	if (r->thread)
+	{
+		n += file_text(suffix + n, ",\"thread\":", 10);
+		n += file_number(suffix + n, r->thread);
+		n += file_text(suffix + n, ",\"thread_name\":\"", 16);
+		n += i_ae_json_escape(suffix + n, r->thread_name, strnlen(r->thread_name, AE_LOG_THREAD_NAME_SIZE - 1));
+		n += file_text(suffix + n, "\",\"sequence\":", 13);
+		n += file_number(suffix + n, r->sequence);
+	}
+
+	if (r->rate > 1)
+	{
+		n += file_text(suffix + n, ",\"sample_rate\":", 15);
+		n += file_number(suffix + n, r->rate);
+	}
+
+	n += i_ae_context_json(suffix + n, r->context, r->context_length);
+	return n + file_text(suffix + n, "}\n", 2);
+}
+
+/// <summary>
+/// Adds a record as a line of the log file. Must be called with s_mutex locked.
+/// </summary>
+static void file_append_text(const ae_record* r, const char* time)
+{
+	char prefix[AE_LOG_FILE_BUFFER_SIZE];
+	uint64_t len = file_prefix(r, time, prefix);
+
+	char suffix[AE_LOG_FILE_SUFFIX_SIZE];
+	uint64_t suffix_length = file_suffix(r, suffix);
+
+	uint64_t size = (uint64_t)len + r->length + suffix_length;
+
+	if (!file_ensure(size))
+	{
+		i_ae_stats_add(AE_STATS_ALLOCATION_FAILURES, 1);
+		return;
+	}
+
+	file_append(prefix, len);
+	file_append(r->message, r->length);
+	file_append(suffix, suffix_length);
+
+	i_ae_stats_add(AE_STATS_BYTES, size);
+}
+
+/// <summary>
+/// Adds a record as a JSON object on its own line. Must be called with s_mutex locked.
+/// </summary>
+static void file_append_json(const ae_record* r, const char* time)
+{
+	// Escaping can make a string up to 6 times longer, the message is escaped in blocks
+	char escaped[AE_LOG_FILE_JSON_BLOCK * 6];
+	char prefix[AE_LOG_FILE_JSON_BLOCK * 6 + 256];
+
+	uint64_t file_length = strlen(r->file);
+
+	if (file_length > AE_LOG_FILE_JSON_BLOCK)
+	{
+		file_length = AE_LOG_FILE_JSON_BLOCK;
+	}
+
+	uint64_t escaped_length = i_ae_json_escape(escaped, r->file, file_length);
+
+	int len = sprintf_s(prefix, sizeof(prefix), "{\"time\":\"%s\",\"level\":\"%s\",\"line\":%d,\"file\":\"%.*s\",\"message\":\"",
+		time, s_labels[r->level], r->line, (int)escaped_length, escaped);
+
+	if (len < 0 || len >= (int)sizeof(prefix))
+	{
+		len = (int)sizeof(prefix) - 1;
+	}
+
+	char suffix[AE_LOG_FILE_SUFFIX_SIZE + I_AE_CONTEXT_JSON_SIZE];
+	uint64_t suffix_length = file_suffix_json(r, suffix);
+
+	// The exact length is not known before the message is escaped, so space for the longest result is made
+	if (!file_ensure((uint64_t)len + r->length * 6 + suffix_length))
+	{
+		i_ae_stats_add(AE_STATS_ALLOCATION_FAILURES, 1);
 		return;
 	}
 
-	s_file_size++;
+	uint64_t size = s_file_size;
 
-	char* data = realloc(s_file_data, s_file_size + 1);
+	file_append(prefix, (uint64_t)len);
 
-	if (data)
+	for (uint64_t i = 0; i < r->length; i += AE_LOG_FILE_JSON_BLOCK)
 	{
-		s_file_data = data;
-		s_file_data[s_file_size - 1] = '\n';
-		s_file_data[s_file_size] = '\0';
+		uint64_t n = r->length - i < AE_LOG_FILE_JSON_BLOCK ? r->length - i : AE_LOG_FILE_JSON_BLOCK;
+		file_append(escaped, i_ae_json_escape(escaped, r->message + i, n));
 	}
+
+	file_append(suffix, suffix_length);
+
+	i_ae_stats_add(AE_STATS_BYTES, s_file_size - size);
 }
 
-#undef ERROR
+static void file_append_record(const ae_record* r, const char* time)
+{
+	if (s_format == AE_LOG_FILE_JSON)
+	{
+		file_append_json(r, time);
+	}
 
-void ae_log_file_export(const char* p)
+	else
+	{
+		file_append_text(r, time);
+	}
+}
+
+void ae_log_file_format_set(ae_log_file_format format)
+{
+	i_ae_mutex_lock(&s_mutex);
+	s_format = format;
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+void ae_log_file_hex_format_set(ae_log_hex_format format)
+{
+	i_ae_mutex_lock(&s_mutex);
+	s_hex_format = format;
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+int ae_log_file_reserve(uint64_t size)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	uint64_t count = (size + AE_LOG_FILE_CHUNK_SIZE - 1) / AE_LOG_FILE_CHUNK_SIZE;
+	s_reserved_count = count;
+
+	if (s_chunk_count >= count)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		return 1;
+	}
+
+	// The missing chunks are carved from one arena so that they can be backed by huge pages
+	uint64_t stride = (sizeof(ae_file_chunk) + AE_LOG_FILE_CHUNK_SIZE + AE_CACHE_LINE - 1) & ~(uint64_t)(AE_CACHE_LINE - 1);
+	file_arena* a = malloc(sizeof(file_arena));
+
+	if (a)
+	{
+		a->size = (count - s_chunk_count) * stride;
+		a->data = i_ae_memory_alloc(a->size, &a->memory);
+	}
+
+	if (!a || !a->data)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		free(a);
+
+		AE_LOG_CONSOLE_ERROR("Failed to reserve memory for the log file.");
+		return 0;
+	}
+
+	// Touching the memory now means that logging does not take page faults later
+	memset(a->data, 0, (size_t)a->size);
+
+	for (uint64_t offset = 0; offset < a->size; offset += stride)
+	{
+		ae_file_chunk* c = (ae_file_chunk*)(a->data + offset);
+		c->capacity = AE_LOG_FILE_CHUNK_SIZE;
+		c->pooled = 1;
+
+		c->next = s_pool;
+		s_pool = c;
+		s_chunk_count++;
+	}
+
+	a->next = s_arenas;
+	s_arenas = a;
+
+	i_ae_mutex_unlock(&s_mutex);
+	return 1;
+}
+
+// Emit ---------------------------------------------------------------------------------------------------------
+
+static void file_emit_sinks(const ae_record* r, const char* time);
+
+/// <summary>
+/// Renders the bytes of a record from AE_LOG_FILE_HEX after its message and returns a record with the result
+/// as its message, which is valid until s_mutex is unlocked. Must be called with s_mutex locked.
+/// </summary>
+static ae_record file_render_data(const ae_record* r)
+{
+	ae_record rendered = *r;
+	char* out = s_hex_buffer;
+
+	uint64_t n = file_text(out, r->message, r->length < AE_LOG_FILE_BUFFER_SIZE ? r->length : AE_LOG_FILE_BUFFER_SIZE - 1);
+
+	n += file_text(out + n, " | Bytes: ", 10);
+	n += file_number(out + n, r->data_offset);
+	n += file_text(out + n, "-", 1);
+	n += file_number(out + n, r->data_offset + r->data_length - 1);
+	n += file_text(out + n, "/", 1);
+	n += file_number(out + n, r->data_size);
+
+	if (s_hex_format == AE_LOG_HEX_DUMP)
+	{
+		n += file_text(out + n, "\n", 1);
+		n += i_ae_hex_dump(out + n, r->data, r->data_length, r->data_offset);
+	}
+
+	else
+	{
+		n += file_text(out + n, " | Hex: ", 8);
+		n += i_ae_hex_encode(out + n, r->data, r->data_length);
+	}
+
+	rendered.message = s_hex_buffer;
+	rendered.length = n;
+	rendered.data = NULL;
+	rendered.data_length = 0;
+
+	return rendered;
+}
+
+void i_ae_log_file_emit(const ae_record* r)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	ae_record rendered;
+
+	if (r->data)
+	{
+		rendered = file_render_data(r);
+		r = &rendered;
+	}
+
+	if (!r->file)
+	{
+		// A blank line is not a valid JSON line
+		if (s_file_size > 0 && s_format == AE_LOG_FILE_TEXT && file_ensure(1))
+		{
+			file_append("\n", 1);
+		}
+
+		i_ae_mutex_unlock(&s_mutex);
+		return;
+	}
+
+	char time[48];
+	i_ae_time_render(r->time, time, sizeof(time));
+
+	file_append_record(r, time);
+	file_emit_sinks(r, time);
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+/// <summary>
+/// Writes records with the same time to the log file and the socket while holding s_mutex once.
+/// </summary>
+static void file_emit_records(const ae_record* r, uint32_t count)
 {
-	if (s_file_size == 0)
+	i_ae_mutex_lock(&s_mutex);
+
+	char time[48];
+	i_ae_time_render(r->time, time, sizeof(time));
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const ae_record* record = &r[i];
+		ae_record rendered;
+
+		if (record->data)
+		{
+			rendered = file_render_data(record);
+			record = &rendered;
+		}
+
+		file_append_record(record, time);
+		file_emit_sinks(record, time);
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+void i_ae_log_file_write_records(ae_record* r, uint32_t count)
+{
+	uint32_t written = i_ae_async_write_records(r, count);
+
+	if (written == count)
 	{
 		return;
 	}
 
-	else if (!p)
+	// Records that are still buffered for the writer thread are written first to keep the log in order
+	i_ae_async_flush();
+
+	uint64_t time = i_ae_time_now();
+
+	for (uint32_t i = written; i < count; i++)
 	{
-		AE_LOG_CONSOLE_NEXT_LINE();
-		AE_LOG_CONSOLE_ERROR("Failed to export log file because the specified path is NULL. Make sure that the specified path is in a directory that exists.");
+		r[i].time = time;
+
+		i_ae_log_shm_write(&r[i]);
+		i_ae_log_trace_write(&r[i]);
+	}
+
+	file_emit_records(r + written, count - written);
+}
+
+/// <summary>
+/// Emits a message that is too long for the message buffer. In the text format the message is formatted
+/// directly into the log file so that it is never copied, after the last line if it fits in the chunk that is
+/// being written and otherwise into a chunk from the pool. Only a message that is longer than a chunk is given
+/// a chunk of its own with the exact size.
+/// </summary>
+static void file_emit_large(ae_record* r, const char* f, va_list args)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	char time[48];
+	i_ae_time_render(r->time, time, sizeof(time));
+
+	char prefix[AE_LOG_FILE_BUFFER_SIZE];
+	uint64_t len = s_format == AE_LOG_FILE_TEXT ? file_prefix(r, time, prefix) : 0;
+
+	char suffix[AE_LOG_FILE_SUFFIX_SIZE];
+	uint64_t suffix_length = file_suffix(r, suffix);
+
+	// Every place the message is formatted into has room for the terminating null character written by vsnprintf
+	uint64_t size = len + r->length + suffix_length;
+
+	ae_file_chunk* c = NULL;
+	char* out;
+
+	if (s_format == AE_LOG_FILE_TEXT && s_current && s_current->capacity - s_current->size > size)
+	{
+		out = s_current->data + s_current->size;
+	}
+
+	else
+	{
+		if (size < AE_LOG_FILE_CHUNK_SIZE)
+		{
+			c = chunk_take();
+		}
+
+		else
+		{
+			c = malloc(sizeof(ae_file_chunk) + size + 1);
+
+			if (c)
+			{
+				c->next = NULL;
+				c->capacity = size;
+				c->pooled = 0;
+			}
+		}
+
+		if (!c)
+		{
+			i_ae_mutex_unlock(&s_mutex);
+
+			i_ae_stats_add(AE_STATS_ALLOCATION_FAILURES, 1);
+			return;
+		}
+
+		out = c->data;
+	}
+
+	char* message = out + len;
+	vsnprintf(message, (size_t)r->length + 1, f, args);
+
+	r->message = message;
+
+	if (s_format == AE_LOG_FILE_TEXT)
+	{
+		memcpy(out, prefix, (size_t)len);
+		memcpy(message + r->length, suffix, (size_t)suffix_length);
+
+		if (c)
+		{
+			c->size = size;
+			file_insert(c);
+		}
+
+		else
+		{
+			s_current->size += size;
+			s_file_size += size;
+			s_file_capacity -= size;
+
+			i_ae_atomic_store_relaxed(&s_file_total, s_file_total + size);
+		}
+
+		i_ae_stats_add(AE_STATS_BYTES, size);
+	}
+
+	else
+	{
+		file_append_record(r, time);
+	}
+
+	i_ae_log_shm_write(r);
+	i_ae_log_trace_write(r);
+
+	file_emit_sinks(r, time);
+
+	// In the JSON format the chunk only held the message while it was escaped into the log file
+	if (s_format != AE_LOG_FILE_TEXT)
+	{
+		chunks_return(c);
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+/// <summary>
+/// Sends a record that was added to the log file to the socket and the subscribers, followed by the stats
+/// report when it is due. Must be called with s_mutex locked.
+/// </summary>
+static void file_emit_sinks(const ae_record* r, const char* time)
+{
+	i_ae_log_socket_write(r);
+	i_ae_log_subscribe_write(r);
+
+	char report[AE_LOG_FILE_BUFFER_SIZE];
+	uint64_t report_len = i_ae_stats_report(r->time, report, sizeof(report));
+
+	if (report_len > 0)
+	{
+		ae_record s = { INFO, __LINE__, __FILE__, r->time, 0, 0, NULL, report, report_len, NULL, 0, NULL, 0, 0, 0,
+			NULL, 0 };
+
+		file_append_record(&s, time);
+		i_ae_log_socket_write(&s);
+		i_ae_log_subscribe_write(&s);
+	}
+}
+
+static void file_sample(uint64_t start, uint64_t format_time)
+{
+	uint64_t time = i_ae_time_now() - start;
+
+	i_ae_stats_add(AE_STATS_SAMPLED_CALLS, 1);
+	i_ae_stats_add(AE_STATS_CALL_TIME, time);
+	i_ae_stats_max(AE_STATS_CALL_TIME_MAX, time);
+	i_ae_stats_add(AE_STATS_FORMAT_TIME, format_time);
+}
+
+static void file_log(i_ae_callsite* s, uint32_t rate, log_level l, const char* fn, int ln, const char* f, va_list args)
+{
+	i_ae_stats_add(AE_STATS_FILE + l, 1);
+
+	int sampled = i_ae_stats_sample();
+	uint64_t start = sampled ? i_ae_time_now() : 0;
+
+	i_ae_thread_info* t = i_ae_thread_info_get();
+	ae_record r = { l, ln, fn, 0, t->sequence++, t->id, t->name, NULL, 0, s ? i_ae_callsite_prefix(s, l, "") : NULL, rate, NULL, 0, 0, 0,
+		t->context->data, t->context->length };
+
+	va_list copy;
+	va_copy(copy, args);
+
+	int written = i_ae_async_write(&r, f, args);
+
+	if (written)
+	{
+		va_end(copy);
+
+		i_ae_log_stream_commit(l);
+
+		// The record is stamped right before it is formatted into the buffer of the thread
+		if (sampled)
+		{
+			file_sample(start, i_ae_time_now() - r.time);
+		}
 
-		free(s_file_data);
-		s_file_size = 0;
 		return;
 	}
 
-	FILE* f;
-	fopen_s(&f, p, "w");
+	r.time = i_ae_time_now();
 
-	if (f)
+	// The length is already known if the message was too long for the buffer of the writer thread
+	if (r.length == 0)
 	{
-		fprintf_s(f, "%s", s_file_data);
+		va_list first;
+		va_copy(first, copy);
 
-		fclose(f);
+		int n = vsnprintf(t_message_buffer, AE_LOG_FILE_BUFFER_SIZE, f, first);
+		va_end(first);
 
-		AE_LOG_CONSOLE_NEXT_LINE();
-		AE_LOG_CONSOLE_INFO("Log file exported to as %s.", p);
+		r.length = n < 0 ? 0 : (uint64_t)n;
+	}
+
+	uint64_t format_time = sampled ? i_ae_time_now() - r.time : 0;
+
+	if (r.length < AE_LOG_FILE_BUFFER_SIZE)
+	{
+		r.message = t_message_buffer;
+
+		i_ae_log_shm_write(&r);
+		i_ae_log_trace_write(&r);
+		i_ae_log_file_emit(&r);
 	}
 
 	else
+	{
+		// Records that are still buffered for the writer thread are written first to keep the log in order
+		i_ae_async_flush();
+
+		r.time = i_ae_time_now();
+		file_emit_large(&r, f, copy);
+	}
+
+	va_end(copy);
+
+	i_ae_log_stream_commit(l);
+
+	if (sampled)
+	{
+		file_sample(start, format_time);
+	}
+}
+
+void i_ae_log_file(log_level l, const char* fn, int ln, const char* f, ...)
+{
+	if ((uint64_t)l < i_ae_atomic_load_relaxed(&s_level))
+	{
+		return;
+	}
+
+	va_list args;
+
+	va_start(args, f);
+	file_log(NULL, 0, l, fn, ln, f, args);
+	va_end(args);
+}
+
+void i_ae_log_file_site(i_ae_callsite* s, log_level l, const char* f, ...)
+{
+	if (l < i_ae_config_level(s, AE_CONFIG_FILE, (log_level)i_ae_atomic_load_relaxed(&s_level)))
+	{
+		return;
+	}
+
+	// Lines of code can also be sampled by the configuration, the decision is made before formatting
+	uint32_t rate = i_ae_config_rate(s, AE_CONFIG_FILE, 0);
+
+	if (rate > 1 && !i_ae_callsite_hit(rate))
+	{
+		return;
+	}
+
+	va_list args;
+
+	va_start(args, f);
+	file_log(s, rate, l, s->file, s->line, f, args);
+	va_end(args);
+}
+
+int i_ae_log_file_enabled(i_ae_callsite* s, log_level l)
+{
+	log_level level = (log_level)i_ae_atomic_load_relaxed(&s_level);
+	return l >= (s ? i_ae_config_level(s, AE_CONFIG_FILE, level) : level);
+}
+
+uint32_t i_ae_log_file_sample(i_ae_callsite* s, uint32_t rate)
+{
+	rate = i_ae_config_rate(s, AE_CONFIG_FILE, rate);
+	return rate <= 1 || i_ae_callsite_hit(rate) ? (rate ? rate : 1) : 0;
+}
+
+void i_ae_log_file_sampled(i_ae_callsite* s, uint32_t rate, log_level l, const char* f, ...)
+{
+	if (l < i_ae_config_level(s, AE_CONFIG_FILE, (log_level)i_ae_atomic_load_relaxed(&s_level)))
+	{
+		return;
+	}
+
+	va_list args;
+
+	va_start(args, f);
+	file_log(s, rate, l, s->file, s->line, f, args);
+	va_end(args);
+}
+
+static int file_write_async(ae_record* r, const char* f, ...)
+{
+	va_list args;
+
+	va_start(args, f);
+	int written = i_ae_async_write(r, f, args);
+	va_end(args);
+
+	return written;
+}
+
+void i_ae_log_file_next_line()
+{
+	// A blank line does not take a sequence number, so that the numbers of the messages of a thread have no gaps
+	i_ae_thread_info* t = i_ae_thread_info_get();
+	ae_record r = { TRACE, 0, NULL, 0, t->sequence, t->id, t->name, NULL, 0, NULL, 0, NULL, 0, 0, 0, NULL, 0 };
+
+	if (!file_write_async(&r, NULL))
+	{
+		r.time = i_ae_time_now();
+		i_ae_log_file_emit(&r);
+	}
+}
+
+void ae_log_file_export(const char* p)
+{
+	uint64_t start = i_ae_time_now();
+
+	ae_log_timer_dump();
+	i_ae_async_flush();
+	ae_log_socket_flush();
+	ae_log_trace_flush();
+
+	// A streamed log file is already on its way to disk and is only written out and synced
+	if (i_ae_log_stream_export())
+	{
+		i_ae_stats_add(AE_STATS_EXPORTS, 1);
+		i_ae_stats_add(AE_STATS_EXPORT_TIME, i_ae_time_now() - start);
+		return;
+	}
+
+	uint64_t end;
+	ae_file_chunk* chunks = i_ae_log_file_detach(&end);
+	uint64_t size = 0;
+
+	for (ae_file_chunk* c = chunks; c; c = c->next)
+	{
+		size += c->size;
+	}
+
+	if (size > 0 && !p)
 	{
 		AE_LOG_CONSOLE_NEXT_LINE();
-		AE_LOG_CONSOLE_ERROR("Failed to export log file because the specified path is incorrect. Make sure that the specified path is in a directory that exists.");
+		AE_LOG_CONSOLE_ERROR("Failed to export log file because the specified path is NULL. Make sure that the specified path is in a directory that exists.");
+	}
+
+	else if (size > 0)
+	{
+		FILE* f;
+		fopen_s(&f, p, "w");
+
+		if (f)
+		{
+			for (ae_file_chunk* c = chunks; c; c = c->next)
+			{
+				fwrite(c->data, 1, (size_t)c->size, f);
+			}
+
+			fclose(f);
+
+			i_ae_stats_add(AE_STATS_EXPORTS, 1);
+			i_ae_stats_add(AE_STATS_EXPORT_TIME, i_ae_time_now() - start);
+
+			AE_LOG_CONSOLE_NEXT_LINE();
+			AE_LOG_CONSOLE_INFO("Log file exported to as %s.", p);
+		}
+
+		else
+		{
+			AE_LOG_CONSOLE_NEXT_LINE();
+			AE_LOG_CONSOLE_ERROR("Failed to export log file because the specified path is incorrect. Make sure that the specified path is in a directory that exists.");
+		}
 	}
 
-	free(s_file_data);
+	i_ae_log_file_release(chunks);
+}
+
+ae_file_chunk* i_ae_log_file_detach(uint64_t* end)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	ae_file_chunk* chunks = s_first;
+	*end = s_file_total;
+
+	s_first = NULL;
+	s_last = NULL;
+	s_current = NULL;
 	s_file_size = 0;
+	s_file_capacity = 0;
+
+	i_ae_mutex_unlock(&s_mutex);
+	return chunks;
+}
+
+void i_ae_log_file_release(ae_file_chunk* c)
+{
+	i_ae_mutex_lock(&s_mutex);
+	chunks_return(c);
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+uint64_t i_ae_log_file_end(void)
+{
+	return i_ae_atomic_load_relaxed(&s_file_total);
 }
@@ -0,0 +1,230 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AE_HEX_AVX2
+#define AE_HEX_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AE_HEX_SSE2
+#endif // __AVX2__
+
+#define AE_HEX_LINE_BYTES 16
+
+// Chunks are handed to the writer thread, or written to the log file, this many at a time
+#define AE_HEX_GROUP 16
+
+static const char s_hex[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+
+static AE_THREAD_LOCAL char t_message_buffer[AE_LOG_FILE_BUFFER_SIZE];
+
+// Encoding -----------------------------------------------------------------------------------------------------
+
+#if defined(AE_HEX_SSE2)
+
+/// <summary>
+/// Turns every byte of a register that holds values from 0 to 15 into its hex digit.
+/// </summary>
+static __m128i digits_128(__m128i nibbles)
+{
+	// Every nibble is moved up to '0', and the nibbles above 9 further up to 'a'
+	__m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+	return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+#endif // AE_HEX_SSE2
+
+#if defined(AE_HEX_AVX2)
+
+static __m256i digits_256(__m256i nibbles)
+{
+	__m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10));
+	return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')), letters);
+}
+
+#endif // AE_HEX_AVX2
+
+uint64_t i_ae_hex_encode(char* out, const unsigned char* in, uint64_t len)
+{
+	uint64_t i = 0;
+
+	// The high and low nibbles are split into two registers, turned into digits and interleaved again
+#if defined(AE_HEX_AVX2)
+	const __m256i wide_mask = _mm256_set1_epi8(0x0F);
+
+	while (i + 32 <= len)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)(in + i));
+		__m256i high = digits_256(_mm256_and_si256(_mm256_srli_epi16(v, 4), wide_mask));
+		__m256i low = digits_256(_mm256_and_si256(v, wide_mask));
+
+		// Unpacking works within each 128-bit lane, so the halves are put back in order afterwards
+		__m256i first = _mm256_unpacklo_epi8(high, low);
+		__m256i second = _mm256_unpackhi_epi8(high, low);
+
+		_mm256_storeu_si256((__m256i*)(out + i * 2), _mm256_permute2x128_si256(first, second, 0x20));
+		_mm256_storeu_si256((__m256i*)(out + i * 2 + 32), _mm256_permute2x128_si256(first, second, 0x31));
+
+		i += 32;
+	}
+#endif // AE_HEX_AVX2
+
+#if defined(AE_HEX_SSE2)
+	const __m128i low_mask = _mm_set1_epi8(0x0F);
+
+	while (i + 16 <= len)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+		__m128i high = digits_128(_mm_and_si128(_mm_srli_epi16(v, 4), low_mask));
+		__m128i low = digits_128(_mm_and_si128(v, low_mask));
+
+		_mm_storeu_si128((__m128i*)(out + i * 2), _mm_unpacklo_epi8(high, low));
+		_mm_storeu_si128((__m128i*)(out + i * 2 + 16), _mm_unpackhi_epi8(high, low));
+
+		i += 16;
+	}
+#endif // AE_HEX_SSE2
+
+	for (; i < len; i++)
+	{
+		out[i * 2] = s_hex[in[i] >> 4];
+		out[i * 2 + 1] = s_hex[in[i] & 0xF];
+	}
+
+	return len * 2;
+}
+
+// Dump ---------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Copies the bytes of a line that are printable, and a '.' for every other byte.
+/// </summary>
+static void dump_text(char* out, const unsigned char* in, uint64_t len)
+{
+	uint64_t i = 0;
+
+#if defined(AE_HEX_SSE2)
+	if (len == AE_HEX_LINE_BYTES)
+	{
+		// Bytes from 0x80 are negative when compared as signed, so only 0x20 to 0x7E are above 0x1F and not 0x7F
+		__m128i v = _mm_loadu_si128((const __m128i*)in);
+		__m128i printable = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(0x7F)), _mm_cmpgt_epi8(v, _mm_set1_epi8(0x1F)));
+
+		_mm_storeu_si128((__m128i*)out, _mm_or_si128(_mm_and_si128(printable, v), _mm_andnot_si128(printable, _mm_set1_epi8('.'))));
+		return;
+	}
+#endif // AE_HEX_SSE2
+
+	for (; i < len; i++)
+	{
+		out[i] = in[i] >= 0x20 && in[i] < 0x7F ? (char)in[i] : '.';
+	}
+}
+
+uint64_t i_ae_hex_dump(char* out, const unsigned char* in, uint64_t len, uint64_t offset)
+{
+	char* start = out;
+
+	for (uint64_t line = 0; line < len; line += AE_HEX_LINE_BYTES)
+	{
+		uint64_t n = len - line < AE_HEX_LINE_BYTES ? len - line : AE_HEX_LINE_BYTES;
+		uint64_t address = offset + line;
+
+		if (line > 0)
+		{
+			*out++ = '\n';
+		}
+
+		for (int shift = 28; shift >= 0; shift -= 4)
+		{
+			*out++ = s_hex[(address >> shift) & 0xF];
+		}
+
+		// The digits of the whole line are encoded at once and then spread out into columns
+		char digits[AE_HEX_LINE_BYTES * 2];
+		i_ae_hex_encode(digits, in + line, n);
+
+		memset(out, ' ', 2 + AE_HEX_LINE_BYTES * 3 + 2);
+		out += 2;
+
+		for (uint64_t i = 0; i < n; i++)
+		{
+			char* column = out + i * 3 + (i >= AE_HEX_LINE_BYTES / 2);
+			column[0] = digits[i * 2];
+			column[1] = digits[i * 2 + 1];
+		}
+
+		out += AE_HEX_LINE_BYTES * 3 + 2;
+
+		*out++ = '|';
+		dump_text(out, in + line, n);
+		out += n;
+		*out++ = '|';
+	}
+
+	return (uint64_t)(out - start);
+}
+
+// Interface ----------------------------------------------------------------------------------------------------
+
+void i_ae_log_file_hex(i_ae_callsite* s, log_level l, const void* p, uint64_t size, const char* f, ...)
+{
+	if (!i_ae_log_file_enabled(s, l))
+	{
+		return;
+	}
+
+	// The message is shared by every chunk and cut to the message buffer, the bytes are never cut
+	va_list args;
+
+	va_start(args, f);
+	int n = vsnprintf(t_message_buffer, AE_LOG_FILE_BUFFER_SIZE, f, args);
+	va_end(args);
+
+	uint64_t length = n < 0 ? 0 : (uint64_t)n;
+	length = length < AE_LOG_FILE_BUFFER_SIZE ? length : AE_LOG_FILE_BUFFER_SIZE - 1;
+
+	const unsigned char* data = p;
+	uint64_t chunks = size > 0 ? (size + AE_LOG_HEX_CHUNK_SIZE - 1) / AE_LOG_HEX_CHUNK_SIZE : 1;
+
+	i_ae_stats_add(AE_STATS_FILE + l, chunks);
+
+	i_ae_thread_info* t = i_ae_thread_info_get();
+	const i_ae_callsite* prefix = i_ae_callsite_prefix(s, l, "");
+
+	ae_record records[AE_HEX_GROUP];
+	uint64_t offset = 0;
+
+	while (chunks > 0)
+	{
+		uint32_t count = chunks < AE_HEX_GROUP ? (uint32_t)chunks : AE_HEX_GROUP;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint64_t chunk = size - offset < AE_LOG_HEX_CHUNK_SIZE ? size - offset : AE_LOG_HEX_CHUNK_SIZE;
+
+			// An empty blob is logged as the message alone
+			ae_record r = { l, s->line, s->file, 0, t->sequence++, t->id, t->name, t_message_buffer, length, prefix, 0,
+				chunk > 0 ? data + offset : NULL, chunk, offset, size, t->context->data, t->context->length };
+
+			records[i] = r;
+			offset += chunk;
+		}
+
+		chunks -= count;
+
+		i_ae_log_file_write_records(records, count);
+	}
+
+	i_ae_log_stream_commit(l);
+}
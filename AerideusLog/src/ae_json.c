@@ -0,0 +1,140 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../internal/ae_internal.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AE_JSON_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AE_JSON_SSE2
+#endif // __AVX2__
+
+static const char s_hex[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+
+/// <summary>
+/// Escapes a single character that JSON does not allow in a string and returns the number of bytes written.
+/// </summary>
+static uint64_t escape_char(char* out, unsigned char c)
+{
+	out[0] = '\\';
+
+	switch (c)
+	{
+	case '"': out[1] = '"'; return 2;
+	case '\\': out[1] = '\\'; return 2;
+	case '\n': out[1] = 'n'; return 2;
+	case '\r': out[1] = 'r'; return 2;
+	case '\t': out[1] = 't'; return 2;
+	case '\b': out[1] = 'b'; return 2;
+	case '\f': out[1] = 'f'; return 2;
+	default: break;
+	}
+
+	out[1] = 'u';
+	out[2] = '0';
+	out[3] = '0';
+	out[4] = s_hex[c >> 4];
+	out[5] = s_hex[c & 0xF];
+
+	return 6;
+}
+
+static int needs_escape(unsigned char c)
+{
+	return c < 0x20 || c == '"' || c == '\\';
+}
+
+static uint32_t lowest_bit(uint32_t v)
+{
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward(&i, v);
+	return (uint32_t)i;
+#else
+	return (uint32_t)__builtin_ctz(v);
+#endif // _MSC_VER
+}
+
+uint64_t i_ae_json_escape(char* out, const char* in, uint64_t len)
+{
+	char* start = out;
+	uint64_t i = 0;
+
+	// Clean spans are copied a whole register at a time, only the characters that need escaping are handled one by one
+#if defined(AE_JSON_AVX2)
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i control = _mm256_set1_epi8(0x1F);
+
+	while (i + 32 <= len)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)(in + i));
+		__m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+			_mm256_cmpeq_epi8(_mm256_max_epu8(v, control), control));
+
+		_mm256_storeu_si256((__m256i*)out, v);
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(special);
+
+		if (mask == 0)
+		{
+			out += 32;
+			i += 32;
+			continue;
+		}
+
+		uint32_t clean = lowest_bit(mask);
+
+		out += clean;
+		out += escape_char(out, (unsigned char)in[i + clean]);
+		i += clean + 1;
+	}
+#elif defined(AE_JSON_SSE2)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i control = _mm_set1_epi8(0x1F);
+
+	while (i + 16 <= len)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+		__m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+			_mm_cmpeq_epi8(_mm_max_epu8(v, control), control));
+
+		_mm_storeu_si128((__m128i*)out, v);
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(special);
+
+		if (mask == 0)
+		{
+			out += 16;
+			i += 16;
+			continue;
+		}
+
+		uint32_t clean = lowest_bit(mask);
+
+		out += clean;
+		out += escape_char(out, (unsigned char)in[i + clean]);
+		i += clean + 1;
+	}
+#endif // AE_JSON_AVX2
+
+	for (; i < len; i++)
+	{
+		unsigned char c = (unsigned char)in[i];
+
+		if (needs_escape(c))
+		{
+			out += escape_char(out, c);
+		}
+
+		else
+		{
+			*out++ = (char)c;
+		}
+	}
+
+	return (uint64_t)(out - start);
+}
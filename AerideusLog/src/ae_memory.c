@@ -0,0 +1,228 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#ifdef AE_LINUX
+#define _GNU_SOURCE
+#endif // AE_LINUX
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef AE_LINUX
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif // AE_LINUX
+
+#define AE_LOG_HUGE_PAGE_SIZE (2ULL << 20)
+
+// From numaif.h, which is part of libnuma and not always installed
+#define AE_LOG_MPOL_PREFERRED 1
+#define AE_LOG_MPOL_MF_MOVE (1 << 1)
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+
+static ae_log_memory_config s_config = { AE_LOG_HUGE_PAGES_OFF, 0 };
+
+// What the buffers that were allocated last actually got, which is less than asked for if huge pages are not available
+static ae_log_memory_config s_effective = { AE_LOG_HUGE_PAGES_OFF, 0 };
+
+// Interface ----------------------------------------------------------------------------------------------------
+
+void ae_log_memory_set(const ae_log_memory_config* c)
+{
+	ae_log_memory_config config = c ? *c : (ae_log_memory_config){ AE_LOG_HUGE_PAGES_OFF, 0 };
+
+	if (config.huge_pages > AE_LOG_HUGE_PAGES_EXPLICIT)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to set the memory policy because the huge page setting is invalid.");
+		return;
+	}
+
+	i_ae_mutex_lock(&s_mutex);
+
+	s_config = config;
+	s_effective = config;
+
+#ifndef AE_LINUX
+	// Huge pages and NUMA placement are only supported on Linux
+	s_effective.huge_pages = AE_LOG_HUGE_PAGES_OFF;
+	s_effective.numa_local = 0;
+#endif // AE_LINUX
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+void ae_log_memory_get(ae_log_memory_config* c)
+{
+	if (!c)
+	{
+		return;
+	}
+
+	i_ae_mutex_lock(&s_mutex);
+	*c = s_effective;
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+// Allocation ---------------------------------------------------------------------------------------------------
+
+#ifdef AE_LINUX
+
+/// <summary>
+/// Maps memory aligned to a huge page, so that transparent huge pages can back all of it.
+/// </summary>
+static void* memory_map_aligned(uint64_t size)
+{
+	uint64_t mapped = size + AE_LOG_HUGE_PAGE_SIZE;
+	char* p = mmap(NULL, (size_t)mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (p == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	char* aligned = (char*)(((uintptr_t)p + AE_LOG_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(AE_LOG_HUGE_PAGE_SIZE - 1));
+	char* end = aligned + size;
+
+	if (aligned > p)
+	{
+		munmap(p, (size_t)(aligned - p));
+	}
+
+	if (p + mapped > end)
+	{
+		munmap(end, (size_t)(p + mapped - end));
+	}
+
+	return aligned;
+}
+
+void* i_ae_memory_alloc(uint64_t size, int* kind)
+{
+	i_ae_mutex_lock(&s_mutex);
+	ae_log_memory_config config = s_config;
+	i_ae_mutex_unlock(&s_mutex);
+
+	if (config.huge_pages == AE_LOG_HUGE_PAGES_OFF && !config.numa_local)
+	{
+		*kind = AE_MEMORY_HEAP;
+		return malloc((size_t)size);
+	}
+
+	uint64_t rounded = (size + AE_LOG_HUGE_PAGE_SIZE - 1) & ~(AE_LOG_HUGE_PAGE_SIZE - 1);
+	ae_log_huge_pages got = config.huge_pages;
+
+	if (config.huge_pages == AE_LOG_HUGE_PAGES_EXPLICIT)
+	{
+		void* p = mmap(NULL, (size_t)rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+		if (p != MAP_FAILED)
+		{
+			*kind = AE_MEMORY_HUGE;
+			return p;
+		}
+
+		// No huge pages are reserved in /proc/sys/vm/nr_hugepages, transparent huge pages are tried instead
+		got = AE_LOG_HUGE_PAGES_TRANSPARENT;
+	}
+
+	void* p = memory_map_aligned(rounded);
+
+	if (!p)
+	{
+		return NULL;
+	}
+
+	if (got == AE_LOG_HUGE_PAGES_TRANSPARENT && madvise(p, (size_t)rounded, MADV_HUGEPAGE) != 0)
+	{
+		got = AE_LOG_HUGE_PAGES_OFF;
+	}
+
+	if (got != config.huge_pages)
+	{
+		i_ae_mutex_lock(&s_mutex);
+
+		int first = s_effective.huge_pages == config.huge_pages;
+		s_effective.huge_pages = got;
+
+		i_ae_mutex_unlock(&s_mutex);
+
+		if (first)
+		{
+			AE_LOG_CONSOLE_WARNING("Huge pages are not available for log buffers, %s pages are used instead.", got == AE_LOG_HUGE_PAGES_OFF ? "normal" : "transparent huge");
+		}
+	}
+
+	*kind = AE_MEMORY_MAPPED;
+	return p;
+}
+
+void i_ae_memory_free(void* p, uint64_t size, int kind)
+{
+	if (kind == AE_MEMORY_HEAP)
+	{
+		free(p);
+	}
+
+	else if (p)
+	{
+		munmap(p, (size_t)((size + AE_LOG_HUGE_PAGE_SIZE - 1) & ~(AE_LOG_HUGE_PAGE_SIZE - 1)));
+	}
+}
+
+void i_ae_memory_place(void* p, uint64_t size, int kind)
+{
+	i_ae_mutex_lock(&s_mutex);
+	int numa_local = s_effective.numa_local;
+	i_ae_mutex_unlock(&s_mutex);
+
+	if (kind == AE_MEMORY_HEAP || !numa_local)
+	{
+		return;
+	}
+
+	unsigned int cpu;
+	unsigned int node;
+
+	if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0 || node >= 64)
+	{
+		return;
+	}
+
+	// Pages that have been touched are moved, the rest are allocated on the node when they are first touched
+	unsigned long mask = 1UL << node;
+	uint64_t rounded = (size + AE_LOG_HUGE_PAGE_SIZE - 1) & ~(AE_LOG_HUGE_PAGE_SIZE - 1);
+
+	syscall(SYS_mbind, p, (unsigned long)rounded, AE_LOG_MPOL_PREFERRED, &mask, sizeof(mask) * 8, AE_LOG_MPOL_MF_MOVE);
+}
+
+#else
+
+void* i_ae_memory_alloc(uint64_t size, int* kind)
+{
+	*kind = AE_MEMORY_HEAP;
+	return malloc((size_t)size);
+}
+
+void i_ae_memory_free(void* p, uint64_t size, int kind)
+{
+	(void)size;
+	(void)kind;
+
+	free(p);
+}
+
+void i_ae_memory_place(void* p, uint64_t size, int kind)
+{
+	(void)p;
+	(void)size;
+	(void)kind;
+}
+
+#endif // AE_LINUX
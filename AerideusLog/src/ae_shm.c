@@ -0,0 +1,249 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+#include "../internal/ae_shm.h"
+
+#include <string.h>
+
+#if defined(AE_LINUX) || defined(AE_MACOS)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Writers are counted in this many stripes, one per cache line, so that threads logging at once do not contend
+#define AE_SHM_WRITER_STRIPES 16
+
+typedef struct
+{
+	volatile uint64_t count;
+	char padding[AE_CACHE_LINE - sizeof(uint64_t)];
+} shm_writers;
+
+// The ring is a pointer stored as an integer so that it can be loaded and swapped atomically
+static volatile uint64_t s_ring = 0;
+static char s_ring_name[256];
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+static shm_writers s_writers[AE_SHM_WRITER_STRIPES];
+
+/// <summary>
+/// Unmaps the ring once no thread is writing to it. Must be called with s_mutex locked.
+/// </summary>
+static void shm_unmap(void)
+{
+	ae_shm_header* h = (ae_shm_header*)(uintptr_t)i_ae_atomic_exchange(&s_ring, 0);
+
+	if (!h)
+	{
+		return;
+	}
+
+	// A writer counts itself before it loads the ring, so once every stripe is 0 no writer can still see it
+	for (uint32_t i = 0; i < AE_SHM_WRITER_STRIPES; i++)
+	{
+		while (i_ae_atomic_load(&s_writers[i].count) != 0)
+		{
+			i_ae_yield();
+		}
+	}
+
+	// The ring is unmapped but not unlinked, the collector unlinks it once it has been drained
+	munmap(h, i_ae_shm_size(h->slot_count));
+}
+
+int ae_log_shm_open(const char* name, uint32_t slots)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	shm_unmap();
+
+	if (!name || slots == 0 || (slots & (slots - 1)) != 0)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to open shared-memory ring because the name is NULL or the slot count is not a power of two.");
+		i_ae_mutex_unlock(&s_mutex);
+		return 0;
+	}
+
+	sprintf_s(s_ring_name, sizeof(s_ring_name), "/%s-%d", name, i_ae_process_id());
+
+	int fd = shm_open(s_ring_name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+	if (fd < 0)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to open shared-memory ring %s.", s_ring_name);
+		i_ae_mutex_unlock(&s_mutex);
+		return 0;
+	}
+
+	uint64_t size = i_ae_shm_size(slots);
+
+	if (ftruncate(fd, (off_t)size) != 0)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to size shared-memory ring %s.", s_ring_name);
+
+		close(fd);
+		shm_unlink(s_ring_name);
+		i_ae_mutex_unlock(&s_mutex);
+		return 0;
+	}
+
+	void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (p == MAP_FAILED)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to map shared-memory ring %s.", s_ring_name);
+
+		shm_unlink(s_ring_name);
+		i_ae_mutex_unlock(&s_mutex);
+		return 0;
+	}
+
+	ae_shm_header* h = p;
+
+	h->version = AE_SHM_VERSION;
+	h->slot_count = slots;
+	h->slot_size = sizeof(ae_shm_slot);
+	h->pid = i_ae_process_id();
+	h->head = 0;
+	h->tail = 0;
+	h->dropped = 0;
+
+	for (uint32_t i = 0; i < slots; i++)
+	{
+		i_ae_shm_slot(h, i)->sequence = i;
+	}
+
+	// The magic is published last so that the collector never reads a half initialized ring
+	i_ae_atomic_store(&h->magic, AE_SHM_MAGIC);
+
+	i_ae_atomic_store(&s_ring, (uint64_t)(uintptr_t)h);
+
+	i_ae_mutex_unlock(&s_mutex);
+	return 1;
+}
+
+void ae_log_shm_close(void)
+{
+	i_ae_mutex_lock(&s_mutex);
+	shm_unmap();
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+/// <summary>
+/// Writes a record to a ring that the calling thread has been counted as a writer of.
+/// </summary>
+static void shm_write(ae_shm_header* h, const ae_record* r)
+{
+	ae_shm_slot* slot;
+	uint64_t pos = i_ae_atomic_load(&h->head);
+
+	for (;;)
+	{
+		slot = i_ae_shm_slot(h, pos);
+
+		int64_t diff = (int64_t)(i_ae_atomic_load(&slot->sequence) - pos);
+
+		if (diff == 0)
+		{
+			if (i_ae_atomic_cas(&h->head, pos, pos + 1))
+			{
+				break;
+			}
+		}
+
+		else if (diff < 0)
+		{
+			// The ring is full, the record is dropped rather than blocking the caller
+			i_ae_atomic_add(&h->dropped, 1);
+			i_ae_stats_add(AE_STATS_DROPPED, 1);
+			return;
+		}
+
+		pos = i_ae_atomic_load(&h->head);
+	}
+
+	const char* fn = r->file;
+	uint64_t fn_len = strlen(fn);
+	uint64_t len = r->length;
+
+	if (fn_len > sizeof(slot->data) / 2)
+	{
+		fn += fn_len - sizeof(slot->data) / 2;
+		fn_len = sizeof(slot->data) / 2;
+	}
+
+	if (len > sizeof(slot->data) - fn_len)
+	{
+		len = sizeof(slot->data) - fn_len;
+	}
+
+	slot->time = r->time;
+	slot->level = (int32_t)r->level;
+	slot->line = r->line;
+	slot->file_length = (uint32_t)fn_len;
+	slot->message_length = (uint32_t)len;
+	slot->thread = r->thread;
+	slot->thread_sequence = r->sequence;
+
+	memset(slot->thread_name, 0, sizeof(slot->thread_name));
+
+	if (r->thread_name)
+	{
+		memcpy(slot->thread_name, r->thread_name, strnlen(r->thread_name, sizeof(slot->thread_name)));
+	}
+
+	memcpy(slot->data, fn, fn_len);
+	memcpy(slot->data + fn_len, r->message, len);
+
+	i_ae_atomic_store(&slot->sequence, pos + 1);
+}
+
+void i_ae_log_shm_write(const ae_record* r)
+{
+	if (!i_ae_atomic_load_relaxed(&s_ring) || !r->file)
+	{
+		return;
+	}
+
+	// The full barrier orders the count before the ring is loaded again, which shm_unmap() relies on
+	volatile uint64_t* writers = &s_writers[r->thread % AE_SHM_WRITER_STRIPES].count;
+	i_ae_atomic_add_full(writers, 1);
+
+	ae_shm_header* h = (ae_shm_header*)(uintptr_t)i_ae_atomic_load(&s_ring);
+
+	if (h)
+	{
+		shm_write(h, r);
+	}
+
+	i_ae_atomic_add(writers, (uint64_t)-1);
+}
+
+#else
+
+int ae_log_shm_open(const char* name, uint32_t slots)
+{
+	(void)name;
+	(void)slots;
+
+	AE_LOG_CONSOLE_ERROR("Failed to open shared-memory ring because it is not supported on this platform.");
+	return 0;
+}
+
+void ae_log_shm_close(void)
+{
+}
+
+void i_ae_log_shm_write(const ae_record* r)
+{
+	(void)r;
+}
+
+#endif // AE_LINUX || AE_MACOS
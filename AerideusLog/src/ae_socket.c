@@ -0,0 +1,526 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#ifdef AE_LINUX
+#define _GNU_SOURCE
+#endif // AE_LINUX
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <string.h>
+
+#if defined(AE_LINUX) || defined(AE_MACOS)
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#ifdef AE_LINUX
+#define AE_LOG_SOCKET_MMSG
+#endif // AE_LINUX
+
+#define AE_LOG_SOCKET_BATCH_SIZE 16384
+#define AE_LOG_SOCKET_BATCH_RECORDS 64
+
+// Room for the start of a record before its context, which is cut to fit
+#define AE_LOG_SOCKET_HEADER_SIZE 512
+
+// Records are held back at most this long before the batch is sent by the flusher thread
+#define AE_LOG_SOCKET_FLUSH_INTERVAL 100000000ULL
+
+// How long to wait before sending a batch again that the listener had no room for
+#define AE_LOG_SOCKET_RETRY_INTERVAL 1000000ULL
+
+// How long to wait before trying to reconnect to a listener that has gone away
+#define AE_LOG_SOCKET_RECONNECT_INTERVAL 1000000000ULL
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+
+static int s_socket = -1;
+static volatile uint64_t s_open = 0;
+static ae_log_socket_format s_format = AE_LOG_SOCKET_PLAIN;
+static struct sockaddr_un s_address;
+static uint64_t s_reconnect_time = 0;
+
+// Records that were dropped because the listener could not be reached, and because it had no room for them
+static uint64_t s_dropped_unavailable = 0;
+static uint64_t s_dropped_full = 0;
+
+static char s_batch[AE_LOG_SOCKET_BATCH_SIZE];
+static uint32_t s_batch_size = 0;
+static uint64_t s_batch_due = 0;
+
+static uint32_t s_record_offsets[AE_LOG_SOCKET_BATCH_RECORDS];
+static uint32_t s_record_count = 0;
+
+// The flusher sends a batch once its first record has waited for the flush interval, and is parked while the
+// batch is empty. Idle is only read and written with s_mutex locked.
+static i_ae_thread s_flusher;
+static int s_flusher_started = 0;
+static int s_flusher_idle = 0;
+static volatile uint32_t s_flusher_wake = 0;
+
+static const char* s_labels[5] = { "TRACE", "INFO", "WARNING", "ERROR", "FATAL" };
+static const int s_severities[5] = { 7, 6, 4, 3, 2 };
+
+static const char* program_name(void)
+{
+#ifdef AE_LINUX
+	extern char* program_invocation_short_name;
+	return program_invocation_short_name;
+#else
+	return getprogname();
+#endif // AE_LINUX
+}
+
+/// <summary>
+/// Tries to connect without blocking. Returns 1 if the socket is connected.
+/// </summary>
+static int socket_connect(void)
+{
+	if (s_socket >= 0)
+	{
+		return 1;
+	}
+
+	uint64_t now = i_ae_time_now();
+
+	if (now < s_reconnect_time)
+	{
+		return 0;
+	}
+
+	s_reconnect_time = now + AE_LOG_SOCKET_RECONNECT_INTERVAL;
+
+	int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+
+	if (fd < 0)
+	{
+		return 0;
+	}
+
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+	if (connect(fd, (struct sockaddr*)&s_address, sizeof(s_address)) != 0)
+	{
+		close(fd);
+		return 0;
+	}
+
+	s_socket = fd;
+	return 1;
+}
+
+static void socket_disconnect(void)
+{
+	if (s_socket >= 0)
+	{
+		close(s_socket);
+		s_socket = -1;
+	}
+}
+
+/// <summary>
+/// Removes the records that were sent from the start of the batch. Must be called with s_mutex locked.
+/// </summary>
+static void batch_consume(uint32_t sent)
+{
+	if (sent == s_record_count)
+	{
+		s_batch_size = 0;
+		s_record_count = 0;
+		return;
+	}
+
+	uint32_t start = s_record_offsets[sent];
+	memmove(s_batch, s_batch + start, s_batch_size - start);
+
+	for (uint32_t i = sent; i < s_record_count; i++)
+	{
+		s_record_offsets[i - sent] = s_record_offsets[i] - start;
+	}
+
+	s_batch_size -= start;
+	s_record_count -= sent;
+}
+
+/// <summary>
+/// Drops the records of the batch and adds them to the counter. Must be called with s_mutex locked.
+/// </summary>
+static void batch_drop(uint64_t* dropped)
+{
+	*dropped += s_record_count;
+	i_ae_stats_add(AE_STATS_DROPPED, s_record_count);
+	i_ae_stats_add(AE_STATS_SOCKET_DROPPED, s_record_count);
+
+	s_batch_size = 0;
+	s_record_count = 0;
+}
+
+/// <summary>
+/// Sends the batch without blocking and returns 1 if it is empty afterwards. The records that the listener has
+/// no room for are kept and sent again after the retry interval, while the batch is dropped if the listener can
+/// not be reached. Must be called with s_mutex locked.
+/// </summary>
+static int batch_send(void)
+{
+	if (s_record_count == 0)
+	{
+		return 1;
+	}
+
+	if (!socket_connect())
+	{
+		batch_drop(&s_dropped_unavailable);
+		return 1;
+	}
+
+	uint32_t sent = 0;
+	int error = 0;
+
+	if (s_format == AE_LOG_SOCKET_PLAIN)
+	{
+		if (send(s_socket, s_batch, s_batch_size, MSG_DONTWAIT) == (ssize_t)s_batch_size)
+		{
+			sent = s_record_count;
+		}
+
+		else
+		{
+			error = errno;
+		}
+	}
+
+	else
+	{
+		// Syslog expects one message per datagram, the batch is sent with as few system calls as possible
+#ifdef AE_LOG_SOCKET_MMSG
+		struct iovec iov[AE_LOG_SOCKET_BATCH_RECORDS];
+		struct mmsghdr msgs[AE_LOG_SOCKET_BATCH_RECORDS];
+
+		memset(msgs, 0, sizeof(struct mmsghdr) * s_record_count);
+
+		for (uint32_t i = 0; i < s_record_count; i++)
+		{
+			uint32_t end = i + 1 < s_record_count ? s_record_offsets[i + 1] : s_batch_size;
+
+			iov[i].iov_base = s_batch + s_record_offsets[i];
+			iov[i].iov_len = end - s_record_offsets[i];
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		while (sent < s_record_count)
+		{
+			int n = sendmmsg(s_socket, msgs + sent, s_record_count - sent, MSG_DONTWAIT);
+
+			if (n <= 0)
+			{
+				error = errno;
+				break;
+			}
+
+			sent += (uint32_t)n;
+		}
+#else
+		for (; sent < s_record_count; sent++)
+		{
+			uint32_t end = sent + 1 < s_record_count ? s_record_offsets[sent + 1] : s_batch_size;
+
+			if (send(s_socket, s_batch + s_record_offsets[sent], end - s_record_offsets[sent], MSG_DONTWAIT) < 0)
+			{
+				error = errno;
+				break;
+			}
+		}
+#endif // AE_LOG_SOCKET_MMSG
+	}
+
+	batch_consume(sent);
+
+	if (s_record_count == 0)
+	{
+		return 1;
+	}
+
+	// The receive buffer of the listener is full, the rest is sent once it has had time to catch up
+	if (error == EAGAIN || error == EWOULDBLOCK || error == ENOBUFS)
+	{
+		s_batch_due = i_ae_time_now() + AE_LOG_SOCKET_RETRY_INTERVAL;
+		return 0;
+	}
+
+	// The listener has gone away or was restarted, a new connection is made later
+	socket_disconnect();
+	batch_drop(&s_dropped_unavailable);
+
+	return 1;
+}
+
+I_AE_THREAD_FUNCTION(socket_flusher, arg)
+{
+	(void)arg;
+
+	i_ae_mutex_lock(&s_mutex);
+
+	while (i_ae_atomic_load(&s_open))
+	{
+		uint64_t timeout = UINT64_MAX;
+
+		if (s_record_count > 0)
+		{
+			uint64_t now = i_ae_time_now();
+
+			// A batch that is kept because the listener had no room for it is due again after the retry interval
+			if (now >= s_batch_due)
+			{
+				batch_send();
+				continue;
+			}
+
+			timeout = s_batch_due - now;
+		}
+
+		// The word is read with the lock held, so a record that is added after the lock is released wakes the
+		// flusher even if it has not parked yet
+		uint32_t word = i_ae_park_prepare(&s_flusher_wake);
+		s_flusher_idle = s_record_count == 0;
+
+		i_ae_mutex_unlock(&s_mutex);
+		i_ae_park(&s_flusher_wake, word, timeout);
+		i_ae_mutex_lock(&s_mutex);
+
+		s_flusher_idle = 0;
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+	return 0;
+}
+
+int ae_log_socket_open(const char* path, ae_log_socket_format format)
+{
+	ae_log_socket_close();
+
+	if (!path || strlen(path) >= sizeof(s_address.sun_path))
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to open log socket because the specified path is NULL or too long.");
+		return 0;
+	}
+
+	i_ae_mutex_lock(&s_mutex);
+
+	memset(&s_address, 0, sizeof(s_address));
+	s_address.sun_family = AF_UNIX;
+	memcpy(s_address.sun_path, path, strlen(path));
+
+	s_format = format;
+	s_reconnect_time = 0;
+	s_dropped_unavailable = 0;
+	s_dropped_full = 0;
+	i_ae_atomic_store(&s_open, 1);
+
+	// The listener does not have to exist yet, connecting is retried when records are sent
+	socket_connect();
+
+	// Without the flusher a batch is still sent when it is full, on errors, on export and when the next record
+	// arrives after the flush interval
+	s_flusher_started = i_ae_thread_create(&s_flusher, socket_flusher, NULL);
+
+	i_ae_mutex_unlock(&s_mutex);
+	return 1;
+}
+
+void ae_log_socket_flush(void)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	if (i_ae_atomic_load(&s_open))
+	{
+		batch_send();
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+void ae_log_socket_close(void)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	if (!i_ae_atomic_load(&s_open))
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		return;
+	}
+
+	// A listener that is behind is given up to the flush interval to make room for the last records
+	uint64_t deadline = i_ae_time_now() + AE_LOG_SOCKET_FLUSH_INTERVAL;
+
+	while (!batch_send() && i_ae_time_now() < deadline)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		i_ae_sleep_us(AE_LOG_SOCKET_RETRY_INTERVAL / 1000);
+		i_ae_mutex_lock(&s_mutex);
+	}
+
+	batch_drop(&s_dropped_full);
+	socket_disconnect();
+
+	uint64_t unavailable = s_dropped_unavailable;
+	uint64_t full = s_dropped_full;
+	i_ae_atomic_store(&s_open, 0);
+
+	int started = s_flusher_started;
+	s_flusher_started = 0;
+
+	i_ae_unpark(&s_flusher_wake);
+	i_ae_mutex_unlock(&s_mutex);
+
+	if (started)
+	{
+		i_ae_thread_join(s_flusher);
+	}
+
+	if (unavailable > 0)
+	{
+		AE_LOG_CONSOLE_WARNING("%llu messages were not sent to %s because the listener was unavailable.", (unsigned long long)unavailable, s_address.sun_path);
+	}
+
+	if (full > 0)
+	{
+		AE_LOG_CONSOLE_WARNING("%llu messages were not sent to %s because the listener could not keep up.", (unsigned long long)full, s_address.sun_path);
+	}
+}
+
+void i_ae_log_socket_write(const ae_record* r)
+{
+	if (!i_ae_atomic_load_relaxed(&s_open) || !r->file)
+	{
+		return;
+	}
+
+	i_ae_mutex_lock(&s_mutex);
+
+	if (!i_ae_atomic_load(&s_open))
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		return;
+	}
+
+	log_level l = r->level;
+	uint64_t len = r->length;
+	uint64_t now = i_ae_time_now();
+
+	if (s_record_count > 0 && now >= s_batch_due)
+	{
+		batch_send();
+	}
+
+	// The context and the start of the message are added after the part that is cut to fit
+	char header[AE_LOG_SOCKET_HEADER_SIZE + I_AE_CONTEXT_TEXT_SIZE + 16];
+	int header_len;
+
+	if (s_format == AE_LOG_SOCKET_PLAIN)
+	{
+		char time[48];
+		i_ae_time_render(r->time, time, sizeof(time));
+
+		header_len = sprintf_s(header, AE_LOG_SOCKET_HEADER_SIZE, "%s [%s] %s | Line: %d", time, s_labels[l], r->file, r->line);
+	}
+
+	else
+	{
+		// RFC 3164 with the 'user' facility, the local daemon adds its own timestamp
+		header_len = sprintf_s(header, AE_LOG_SOCKET_HEADER_SIZE, "<%d>%s[%d]: [%s] %s | Line: %d", 8 + s_severities[l],
+			program_name(), i_ae_process_id(), s_labels[l], r->file, r->line);
+	}
+
+	if (header_len < 0 || header_len >= AE_LOG_SOCKET_HEADER_SIZE)
+	{
+		header_len = AE_LOG_SOCKET_HEADER_SIZE - 1;
+	}
+
+	header_len += (int)i_ae_context_text(header + header_len, r->context, r->context_length);
+
+	memcpy(header + header_len, " | Message: '", 13);
+	header_len += 13;
+
+	uint64_t size = (uint64_t)header_len + len + 2;
+
+	if (size > AE_LOG_SOCKET_BATCH_SIZE)
+	{
+		len = AE_LOG_SOCKET_BATCH_SIZE - (uint64_t)header_len - 2;
+		size = AE_LOG_SOCKET_BATCH_SIZE;
+	}
+
+	if (s_batch_size + size > AE_LOG_SOCKET_BATCH_SIZE || s_record_count == AE_LOG_SOCKET_BATCH_RECORDS)
+	{
+		batch_send();
+
+		// The records that the listener still has no room for are dropped to make room for the new one
+		if (s_batch_size + size > AE_LOG_SOCKET_BATCH_SIZE || s_record_count == AE_LOG_SOCKET_BATCH_RECORDS)
+		{
+			batch_drop(&s_dropped_full);
+		}
+	}
+
+	if (s_record_count == 0)
+	{
+		s_batch_due = now + AE_LOG_SOCKET_FLUSH_INTERVAL;
+	}
+
+	char* p = s_batch + s_batch_size;
+
+	memcpy(p, header, (size_t)header_len);
+	memcpy(p + header_len, r->message, (size_t)len);
+	p[header_len + len] = '\'';
+	p[header_len + len + 1] = '\n';
+
+	s_record_offsets[s_record_count++] = s_batch_size;
+	s_batch_size += (uint32_t)size;
+
+	// Problems are sent right away so that they are not lost if the process terminates
+	if (l >= ERROR)
+	{
+		batch_send();
+	}
+
+	// The flusher is only woken for the first record of a batch, it then parks until the batch is due
+	else if (s_flusher_idle)
+	{
+		s_flusher_idle = 0;
+		i_ae_unpark(&s_flusher_wake);
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+#else
+
+int ae_log_socket_open(const char* path, ae_log_socket_format format)
+{
+	(void)path;
+	(void)format;
+
+	AE_LOG_CONSOLE_ERROR("Failed to open log socket because Unix domain sockets are not supported on this platform.");
+	return 0;
+}
+
+void ae_log_socket_flush(void)
+{
+}
+
+void ae_log_socket_close(void)
+{
+}
+
+void i_ae_log_socket_write(const ae_record* r)
+{
+	(void)r;
+}
+
+#endif // AE_LINUX || AE_MACOS
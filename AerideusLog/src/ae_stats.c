@@ -0,0 +1,240 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <string.h>
+
+#define AE_STATS_MAX_THREADS 256
+
+/// <summary>
+/// Counters of one thread. Only the owning thread writes to a slot, so counting needs no atomic read-
+/// modify-write. Threads that do not get a slot of their own share the last one and count atomically.
+/// </summary>
+typedef struct
+{
+	volatile uint64_t counters[AE_STATS_COUNT];
+	volatile uint64_t used;
+	char padding[AE_CACHE_LINE - ((AE_STATS_COUNT + 1) * 8) % AE_CACHE_LINE];
+} stats_slot;
+
+static AE_ALIGN(AE_CACHE_LINE) stats_slot s_slots[AE_STATS_MAX_THREADS + 1];
+static uint64_t s_retired[AE_STATS_COUNT];
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+static i_ae_tls_key s_key;
+static int s_key_created = 0;
+
+static volatile uint64_t s_sample_rate = 0;
+static volatile uint64_t s_report_interval = 0;
+static uint64_t s_report_time = 0;
+
+static AE_THREAD_LOCAL stats_slot* t_slot = NULL;
+static AE_THREAD_LOCAL uint64_t t_calls = 0;
+
+static stats_slot* shared_slot(void)
+{
+	return &s_slots[AE_STATS_MAX_THREADS];
+}
+
+/// <summary>
+/// Called when a thread with a slot exits. Its counts are kept in the retired totals.
+/// </summary>
+static void slot_release(void* p)
+{
+	stats_slot* slot = p;
+
+	i_ae_mutex_lock(&s_mutex);
+
+	for (uint32_t i = 0; i < AE_STATS_COUNT; i++)
+	{
+		if (i == AE_STATS_CALL_TIME_MAX)
+		{
+			s_retired[i] = slot->counters[i] > s_retired[i] ? slot->counters[i] : s_retired[i];
+		}
+
+		else
+		{
+			s_retired[i] += slot->counters[i];
+		}
+
+		i_ae_atomic_store_relaxed(&slot->counters[i], 0);
+	}
+
+	i_ae_atomic_store(&slot->used, 0);
+
+	i_ae_mutex_unlock(&s_mutex);
+
+	t_slot = shared_slot();
+}
+
+static stats_slot* slot_attach(void)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	if (!s_key_created)
+	{
+		s_key_created = i_ae_tls_key_create(&s_key, slot_release);
+	}
+
+	stats_slot* slot = shared_slot();
+
+	for (uint32_t i = 0; s_key_created && i < AE_STATS_MAX_THREADS; i++)
+	{
+		if (!s_slots[i].used)
+		{
+			slot = &s_slots[i];
+			i_ae_atomic_store(&slot->used, 1);
+
+			i_ae_tls_set(s_key, slot);
+			break;
+		}
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+
+	t_slot = slot;
+	return slot;
+}
+
+void i_ae_stats_add(uint32_t counter, uint64_t v)
+{
+	stats_slot* slot = t_slot ? t_slot : slot_attach();
+
+	if (slot == shared_slot())
+	{
+		i_ae_atomic_add(&slot->counters[counter], v);
+	}
+
+	else
+	{
+		i_ae_atomic_store_relaxed(&slot->counters[counter], i_ae_atomic_load_relaxed(&slot->counters[counter]) + v);
+	}
+}
+
+void i_ae_stats_max(uint32_t counter, uint64_t v)
+{
+	stats_slot* slot = t_slot ? t_slot : slot_attach();
+
+	uint64_t current = i_ae_atomic_load_relaxed(&slot->counters[counter]);
+
+	while (v > current)
+	{
+		if (slot != shared_slot())
+		{
+			i_ae_atomic_store_relaxed(&slot->counters[counter], v);
+			return;
+		}
+
+		if (i_ae_atomic_cas(&slot->counters[counter], current, v))
+		{
+			return;
+		}
+
+		current = i_ae_atomic_load(&slot->counters[counter]);
+	}
+}
+
+int i_ae_stats_sample(void)
+{
+	uint64_t rate = s_sample_rate;
+
+	return rate != 0 && ++t_calls % rate == 0;
+}
+
+void ae_log_stats_get(ae_log_stats* s)
+{
+	uint64_t totals[AE_STATS_COUNT];
+
+	i_ae_mutex_lock(&s_mutex);
+
+	memcpy(totals, s_retired, sizeof(totals));
+
+	for (uint32_t i = 0; i <= AE_STATS_MAX_THREADS; i++)
+	{
+		stats_slot* slot = &s_slots[i];
+
+		for (uint32_t c = 0; c < AE_STATS_COUNT; c++)
+		{
+			uint64_t v = i_ae_atomic_load_relaxed(&slot->counters[c]);
+
+			if (c == AE_STATS_CALL_TIME_MAX)
+			{
+				totals[c] = v > totals[c] ? v : totals[c];
+			}
+
+			else
+			{
+				totals[c] += v;
+			}
+		}
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+
+	for (uint32_t l = TRACE; l <= FATAL; l++)
+	{
+		s->console_records[l] = totals[AE_STATS_CONSOLE + l];
+		s->file_records[l] = totals[AE_STATS_FILE + l];
+	}
+
+	s->bytes = totals[AE_STATS_BYTES];
+	s->dropped = totals[AE_STATS_DROPPED];
+	s->socket_dropped = totals[AE_STATS_SOCKET_DROPPED];
+	s->allocation_failures = totals[AE_STATS_ALLOCATION_FAILURES];
+	s->queue_depth = i_ae_async_depth();
+	s->sampled_calls = totals[AE_STATS_SAMPLED_CALLS];
+	s->sampled_call_time = totals[AE_STATS_CALL_TIME];
+	s->sampled_format_time = totals[AE_STATS_FORMAT_TIME];
+	s->max_call_time = totals[AE_STATS_CALL_TIME_MAX];
+	s->exports = totals[AE_STATS_EXPORTS];
+	s->export_time = totals[AE_STATS_EXPORT_TIME];
+}
+
+void ae_log_stats_sample_set(uint32_t n)
+{
+	i_ae_atomic_store(&s_sample_rate, n);
+}
+
+void ae_log_stats_report_set(uint32_t interval)
+{
+	i_ae_atomic_store(&s_report_interval, (uint64_t)interval * 1000000);
+}
+
+uint64_t i_ae_stats_report(uint64_t time, char* buffer, uint64_t size)
+{
+	uint64_t interval = s_report_interval;
+
+	if (interval == 0 || time < s_report_time)
+	{
+		return 0;
+	}
+
+	int first = s_report_time == 0;
+	s_report_time = time + interval;
+
+	// The first message only starts the interval
+	if (first)
+	{
+		return 0;
+	}
+
+	ae_log_stats s;
+	ae_log_stats_get(&s);
+
+	uint64_t calls = s.sampled_calls ? s.sampled_calls : 1;
+
+	int len = sprintf_s(buffer, (size_t)size, "Stats | File: %llu/%llu/%llu/%llu/%llu | Console: %llu/%llu/%llu/%llu/%llu | Bytes: %llu | Dropped: %llu | Allocation failures: %llu | Queue: %llu bytes | Call: %llu ns avg, %llu ns max | Format: %llu ns avg",
+		(unsigned long long)s.file_records[TRACE], (unsigned long long)s.file_records[INFO], (unsigned long long)s.file_records[WARNING],
+		(unsigned long long)s.file_records[ERROR], (unsigned long long)s.file_records[FATAL],
+		(unsigned long long)s.console_records[TRACE], (unsigned long long)s.console_records[INFO], (unsigned long long)s.console_records[WARNING],
+		(unsigned long long)s.console_records[ERROR], (unsigned long long)s.console_records[FATAL],
+		(unsigned long long)s.bytes, (unsigned long long)s.dropped, (unsigned long long)s.allocation_failures, (unsigned long long)s.queue_depth,
+		(unsigned long long)(s.sampled_call_time / calls), (unsigned long long)s.max_call_time, (unsigned long long)(s.sampled_format_time / calls));
+
+	return len < 0 ? 0 : len >= (int)size ? size - 1 : (uint64_t)len;
+}
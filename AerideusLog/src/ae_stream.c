@@ -0,0 +1,455 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#ifdef AE_LINUX
+#define _GNU_SOURCE
+#endif // AE_LINUX
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(AE_LINUX) || defined(AE_MACOS)
+
+#include <fcntl.h>
+
+// Direct writes must start at, and have a size that is a multiple of, the block size of the file system
+#define AE_LOG_STREAM_BLOCK_SIZE 4096
+#define AE_LOG_STREAM_DIRECT_BUFFER_SIZE (256 * AE_LOG_STREAM_BLOCK_SIZE)
+
+// The flusher sleeps in steps of this many milliseconds so that it can be stopped quickly
+#define AE_LOG_STREAM_SLEEP_STEP 10
+
+#ifdef AE_LINUX
+#define stream_datasync(fd) fdatasync(fd)
+#else
+#define stream_datasync(fd) fsync(fd)
+#endif // AE_LINUX
+
+// Held while the log file is written to the stream, a thread that waits for it may find its records synced
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+
+static int s_fd = -1;
+static volatile uint64_t s_open = 0;
+static volatile uint64_t s_group = 0;
+static ae_log_file_stream_config s_config;
+static char s_path[256];
+static int s_failed = 0;
+
+// The number of bytes of the log file that are known to be on disk
+static volatile uint64_t s_durable = 0;
+
+// Direct writes go through an aligned buffer, the offset is where the first byte of the buffer belongs
+static char* s_direct = NULL;
+static uint64_t s_direct_used = 0;
+static uint64_t s_direct_offset = 0;
+
+static i_ae_thread s_flusher;
+
+// Writing ------------------------------------------------------------------------------------------------------
+
+static void stream_error(const char* action)
+{
+	// Reported once per stream so that a full disk does not flood the console
+	if (!s_failed)
+	{
+		s_failed = 1;
+		AE_LOG_CONSOLE_ERROR("Failed to %s the streamed log file %s (error %d).", action, s_path, errno);
+	}
+}
+
+static void stream_write_all(const char* data, uint64_t size)
+{
+	while (size > 0)
+	{
+		ssize_t n = write(s_fd, data, (size_t)size);
+
+		if (n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if (n <= 0)
+		{
+			stream_error("write");
+			return;
+		}
+
+		data += n;
+		size -= (uint64_t)n;
+	}
+}
+
+/// <summary>
+/// Writes the given number of bytes from the start of the aligned buffer to where they belong in the file.
+/// </summary>
+static void direct_write(uint64_t size)
+{
+	uint64_t done = 0;
+
+	while (done < size)
+	{
+		ssize_t n = pwrite(s_fd, s_direct + done, (size_t)(size - done), (off_t)(s_direct_offset + done));
+
+		if (n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if (n <= 0)
+		{
+			stream_error("write");
+			return;
+		}
+
+		done += (uint64_t)n;
+	}
+}
+
+/// <summary>
+/// Adds bytes to the aligned buffer and writes every full block. The last partial block stays in the buffer.
+/// </summary>
+static void direct_append(const char* data, uint64_t size)
+{
+	while (size > 0)
+	{
+		uint64_t room = AE_LOG_STREAM_DIRECT_BUFFER_SIZE - s_direct_used;
+		uint64_t n = size < room ? size : room;
+
+		memcpy(s_direct + s_direct_used, data, (size_t)n);
+
+		s_direct_used += n;
+		data += n;
+		size -= n;
+
+		uint64_t blocks = s_direct_used & ~(uint64_t)(AE_LOG_STREAM_BLOCK_SIZE - 1);
+
+		if (s_direct_used == AE_LOG_STREAM_DIRECT_BUFFER_SIZE || (size == 0 && blocks > 0))
+		{
+			direct_write(blocks);
+
+			s_direct_offset += blocks;
+			s_direct_used -= blocks;
+
+			memmove(s_direct, s_direct + blocks, (size_t)s_direct_used);
+		}
+	}
+}
+
+/// <summary>
+/// Writes the last partial block padded to a full block, and cuts the padding off the end of the file. The
+/// block is written again once it has been filled.
+/// </summary>
+static void direct_write_tail(void)
+{
+	if (s_direct_used == 0)
+	{
+		return;
+	}
+
+	memset(s_direct + s_direct_used, 0, (size_t)(AE_LOG_STREAM_BLOCK_SIZE - s_direct_used));
+	direct_write(AE_LOG_STREAM_BLOCK_SIZE);
+
+	if (ftruncate(s_fd, (off_t)(s_direct_offset + s_direct_used)) != 0)
+	{
+		stream_error("truncate");
+	}
+}
+
+/// <summary>
+/// Writes everything that has been added to the log file to the stream and syncs it if requested. Must be
+/// called with s_mutex locked.
+/// </summary>
+static void stream_write(int sync)
+{
+	uint64_t end;
+	ae_file_chunk* chunks = i_ae_log_file_detach(&end);
+
+	for (ae_file_chunk* c = chunks; c; c = c->next)
+	{
+		if (s_direct)
+		{
+			direct_append(c->data, c->size);
+		}
+
+		else
+		{
+			stream_write_all(c->data, c->size);
+		}
+	}
+
+	i_ae_log_file_release(chunks);
+
+	if (!sync)
+	{
+		return;
+	}
+
+	if (s_direct)
+	{
+		direct_write_tail();
+	}
+
+	if (stream_datasync(s_fd) != 0)
+	{
+		stream_error("sync");
+	}
+
+	i_ae_atomic_store(&s_durable, end);
+}
+
+I_AE_THREAD_FUNCTION(flusher_main, arg)
+{
+	(void)arg;
+
+	uint32_t slept = 0;
+
+	while (i_ae_atomic_load(&s_open))
+	{
+		i_ae_sleep_us(AE_LOG_STREAM_SLEEP_STEP * 1000);
+		slept += AE_LOG_STREAM_SLEEP_STEP;
+
+		if (slept < s_config.interval)
+		{
+			continue;
+		}
+
+		slept = 0;
+
+		i_ae_mutex_lock(&s_mutex);
+		stream_write(s_config.durability == AE_LOG_FILE_DURABILITY_PERIODIC);
+		i_ae_mutex_unlock(&s_mutex);
+	}
+
+	I_AE_THREAD_RETURN;
+}
+
+// Interface ----------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Opens the file for direct writes. Returns -1 if the file system does not support them.
+/// </summary>
+static int stream_open_direct(const char* path)
+{
+#ifdef AE_LINUX
+	return open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+#else
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+	if (fd >= 0 && fcntl(fd, F_NOCACHE, 1) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+#endif // AE_LINUX
+}
+
+int ae_log_file_stream_open(const char* path, const ae_log_file_stream_config* c)
+{
+	ae_log_file_stream_close();
+
+	ae_log_file_stream_config config = c ? *c : (ae_log_file_stream_config){ AE_LOG_FILE_DURABILITY_PERIODIC, 1000, 0 };
+
+	if (!path || strlen(path) >= sizeof(s_path) || config.interval == 0 || config.durability > AE_LOG_FILE_DURABILITY_GROUP)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to open streamed log file because the path is NULL or too long, or the configuration is invalid.");
+		return 0;
+	}
+
+	i_ae_mutex_lock(&s_mutex);
+
+	int fd = -1;
+
+	if (config.direct)
+	{
+		fd = stream_open_direct(path);
+
+		if (fd >= 0 && posix_memalign((void**)&s_direct, AE_LOG_STREAM_BLOCK_SIZE, AE_LOG_STREAM_DIRECT_BUFFER_SIZE) != 0)
+		{
+			s_direct = NULL;
+		}
+
+		if (fd < 0 || !s_direct)
+		{
+			AE_LOG_CONSOLE_WARNING("Direct writes are not supported for %s, the page cache is used instead.", path);
+
+			if (fd >= 0)
+			{
+				close(fd);
+				fd = -1;
+			}
+		}
+	}
+
+	if (fd < 0)
+	{
+		fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	}
+
+	if (fd < 0)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+
+		free(s_direct);
+		s_direct = NULL;
+
+		AE_LOG_CONSOLE_ERROR("Failed to open streamed log file because the specified path is incorrect. Make sure that the specified path is in a directory that exists.");
+		return 0;
+	}
+
+	s_fd = fd;
+	s_config = config;
+	s_failed = 0;
+	s_direct_used = 0;
+	s_direct_offset = 0;
+
+	sprintf_s(s_path, sizeof(s_path), "%s", path);
+
+	// What was logged before the stream was opened becomes the start of the file
+	stream_write(0);
+
+	i_ae_atomic_store(&s_durable, 0);
+	i_ae_atomic_store(&s_group, config.durability == AE_LOG_FILE_DURABILITY_GROUP);
+	i_ae_atomic_store(&s_open, 1);
+
+	if (!i_ae_thread_create(&s_flusher, flusher_main, NULL))
+	{
+		i_ae_atomic_store(&s_open, 0);
+		i_ae_mutex_unlock(&s_mutex);
+
+		ae_log_file_stream_close();
+
+		AE_LOG_CONSOLE_ERROR("Failed to open streamed log file because the flusher thread could not be created.");
+		return 0;
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+	return 1;
+}
+
+void ae_log_file_stream_flush(void)
+{
+	if (!i_ae_atomic_load(&s_open))
+	{
+		return;
+	}
+
+	i_ae_async_flush();
+
+	i_ae_mutex_lock(&s_mutex);
+
+	if (s_fd >= 0)
+	{
+		stream_write(1);
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+void ae_log_file_stream_close(void)
+{
+	i_ae_atomic_store(&s_group, 0);
+
+	if (i_ae_atomic_exchange(&s_open, 0))
+	{
+		i_ae_thread_join(s_flusher);
+	}
+
+	i_ae_async_flush();
+
+	i_ae_mutex_lock(&s_mutex);
+
+	if (s_fd < 0)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		return;
+	}
+
+	stream_write(1);
+	close(s_fd);
+
+	s_fd = -1;
+
+	free(s_direct);
+	s_direct = NULL;
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+void i_ae_log_stream_commit(log_level l)
+{
+	if (l < ERROR || !i_ae_atomic_load_relaxed(&s_group))
+	{
+		return;
+	}
+
+	// Records handed to the writer thread must reach the log file before it can be synced, an error in the
+	// priority lane does not wait for the backlog of other messages
+	i_ae_async_flush_level(l);
+
+	uint64_t target = i_ae_log_file_end();
+
+	// Threads that arrive while a sync is in progress queue on the mutex, the first of them syncs for all
+	// of them and the others find their records already on disk
+	i_ae_mutex_lock(&s_mutex);
+
+	if (s_fd >= 0 && i_ae_atomic_load(&s_durable) < target)
+	{
+		stream_write(1);
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+int i_ae_log_stream_export(void)
+{
+	if (!i_ae_atomic_load(&s_open))
+	{
+		return 0;
+	}
+
+	ae_log_file_stream_flush();
+
+	AE_LOG_CONSOLE_NEXT_LINE();
+	AE_LOG_CONSOLE_INFO("Log file is streamed to %s and was synced.", s_path);
+
+	return 1;
+}
+
+#else
+
+int ae_log_file_stream_open(const char* path, const ae_log_file_stream_config* c)
+{
+	(void)path;
+	(void)c;
+
+	AE_LOG_CONSOLE_ERROR("Failed to open streamed log file because it is not supported on this platform.");
+	return 0;
+}
+
+void ae_log_file_stream_flush(void)
+{
+}
+
+void ae_log_file_stream_close(void)
+{
+}
+
+void i_ae_log_stream_commit(log_level l)
+{
+	(void)l;
+}
+
+int i_ae_log_stream_export(void)
+{
+	return 0;
+}
+
+#endif // AE_LINUX || AE_MACOS
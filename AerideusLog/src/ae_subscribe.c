@@ -0,0 +1,291 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Must be a power of two, a subscriber that falls this many records behind loses its position
+#define AE_LOG_SUBSCRIBE_SLOTS 4096
+
+// How long a callback subscriber sleeps when there is nothing new
+#define AE_LOG_SUBSCRIBE_IDLE_US 1000
+
+#define AE_LOG_SUBSCRIBE_WORDS (sizeof(ae_log_entry) / 8)
+#define AE_LOG_SUBSCRIBE_HEADER_WORDS (offsetof(ae_log_entry, message) / 8)
+
+/// <summary>
+/// A record in the ring. The version is odd while the slot is written and 2 * (sequence + 1) once the record
+/// with that sequence is complete. The entry is copied word by word so that readers never see a torn word.
+/// </summary>
+typedef struct
+{
+	volatile uint64_t version;
+	volatile uint64_t words[AE_LOG_SUBSCRIBE_WORDS];
+} subscribe_slot;
+
+typedef union
+{
+	ae_log_entry entry;
+	uint64_t words[AE_LOG_SUBSCRIBE_WORDS];
+} subscribe_entry;
+
+struct ae_log_cursor
+{
+	uint64_t position;
+	ae_log_subscriber callback;
+	void* user;
+	i_ae_thread thread;
+	volatile uint64_t running;
+};
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+
+// The ring is created for the first subscriber and kept since a record may be written to it at any time
+static subscribe_slot* s_ring = NULL;
+static volatile uint64_t s_subscribers = 0;
+
+// The sequence of the next record, only written by the thread that holds the log file lock
+static volatile uint64_t s_head = 0;
+
+// Reading ------------------------------------------------------------------------------------------------------
+
+static uint64_t entry_words(uint64_t length)
+{
+	return AE_LOG_SUBSCRIBE_HEADER_WORDS + (length + 1 + 7) / 8;
+}
+
+/// <summary>
+/// Moves a cursor that fell behind to the oldest record that can not be overwritten while it is read, and
+/// fills in a gap notice for the records it skipped.
+/// </summary>
+static int cursor_gap(ae_log_cursor* c, ae_log_entry* e)
+{
+	uint64_t head = i_ae_atomic_load(&s_head);
+
+	// The writer may already be overwriting the slot of the oldest record
+	uint64_t oldest = head >= AE_LOG_SUBSCRIBE_SLOTS ? head - AE_LOG_SUBSCRIBE_SLOTS + 1 : 0;
+	oldest = oldest > c->position ? oldest : c->position + 1;
+
+	memset(e, 0, offsetof(ae_log_entry, message));
+
+	e->sequence = c->position;
+	e->lost = oldest - c->position;
+	e->message[0] = '\0';
+
+	c->position = oldest;
+	return 1;
+}
+
+int ae_log_cursor_poll(ae_log_cursor* c, ae_log_entry* e)
+{
+	if (!c || !e)
+	{
+		return 0;
+	}
+
+	uint64_t p = c->position;
+	uint64_t head = i_ae_atomic_load(&s_head);
+
+	if (p >= head)
+	{
+		return 0;
+	}
+
+	if (head - p >= AE_LOG_SUBSCRIBE_SLOTS)
+	{
+		return cursor_gap(c, e);
+	}
+
+	subscribe_slot* slot = &s_ring[p & (AE_LOG_SUBSCRIBE_SLOTS - 1)];
+	uint64_t version = i_ae_atomic_load(&slot->version);
+
+	if (version != (p + 1) * 2)
+	{
+		return cursor_gap(c, e);
+	}
+
+	subscribe_entry s;
+
+	for (uint64_t i = 0; i < AE_LOG_SUBSCRIBE_HEADER_WORDS; i++)
+	{
+		s.words[i] = i_ae_atomic_load(&slot->words[i]);
+	}
+
+	// The length may be torn if the slot is being overwritten, it is only trusted after the version check
+	uint64_t length = s.entry.length < AE_LOG_ENTRY_MESSAGE_SIZE ? s.entry.length : AE_LOG_ENTRY_MESSAGE_SIZE - 1;
+	uint64_t count = entry_words(length);
+
+	for (uint64_t i = AE_LOG_SUBSCRIBE_HEADER_WORDS; i < count; i++)
+	{
+		s.words[i] = i_ae_atomic_load(&slot->words[i]);
+	}
+
+	// The words are loaded with acquire so that the version can not be loaded before them
+	if (i_ae_atomic_load_relaxed(&slot->version) != version)
+	{
+		return cursor_gap(c, e);
+	}
+
+	memcpy(e, &s, (size_t)(count * 8));
+
+	c->position = p + 1;
+	return 1;
+}
+
+I_AE_THREAD_FUNCTION(dispatch_main, arg)
+{
+	ae_log_cursor* c = arg;
+	ae_log_entry e;
+
+	while (i_ae_atomic_load(&c->running))
+	{
+		if (ae_log_cursor_poll(c, &e))
+		{
+			c->callback(&e, c->user);
+		}
+
+		else
+		{
+			i_ae_sleep_us(AE_LOG_SUBSCRIBE_IDLE_US);
+		}
+	}
+
+	I_AE_THREAD_RETURN;
+}
+
+// Interface ----------------------------------------------------------------------------------------------------
+
+ae_log_cursor* ae_log_subscribe(void)
+{
+	ae_log_cursor* c = calloc(1, sizeof(ae_log_cursor));
+
+	if (!c)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to subscribe to the log because memory could not be allocated.");
+		return NULL;
+	}
+
+	i_ae_mutex_lock(&s_mutex);
+
+	if (!s_ring)
+	{
+		s_ring = calloc(AE_LOG_SUBSCRIBE_SLOTS, sizeof(subscribe_slot));
+
+		if (!s_ring)
+		{
+			i_ae_mutex_unlock(&s_mutex);
+			free(c);
+
+			AE_LOG_CONSOLE_ERROR("Failed to subscribe to the log because memory could not be allocated.");
+			return NULL;
+		}
+	}
+
+	// The cursor starts at the next record, what was logged before it subscribed is not delivered
+	c->position = i_ae_atomic_load(&s_head);
+	i_ae_atomic_add(&s_subscribers, 1);
+
+	i_ae_mutex_unlock(&s_mutex);
+	return c;
+}
+
+ae_log_cursor* ae_log_subscribe_callback(ae_log_subscriber fn, void* user)
+{
+	if (!fn)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to subscribe to the log because the specified callback is NULL.");
+		return NULL;
+	}
+
+	ae_log_cursor* c = ae_log_subscribe();
+
+	if (!c)
+	{
+		return NULL;
+	}
+
+	c->callback = fn;
+	c->user = user;
+	c->running = 1;
+
+	if (!i_ae_thread_create(&c->thread, dispatch_main, c))
+	{
+		c->running = 0;
+		ae_log_unsubscribe(c);
+
+		AE_LOG_CONSOLE_ERROR("Failed to subscribe to the log because the dispatch thread could not be created.");
+		return NULL;
+	}
+
+	return c;
+}
+
+void ae_log_unsubscribe(ae_log_cursor* c)
+{
+	if (!c)
+	{
+		return;
+	}
+
+	if (i_ae_atomic_exchange(&c->running, 0))
+	{
+		i_ae_thread_join(c->thread);
+	}
+
+	i_ae_atomic_add(&s_subscribers, (uint64_t)-1);
+	free(c);
+}
+
+void i_ae_log_subscribe_write(const ae_record* r)
+{
+	if (!i_ae_atomic_load(&s_subscribers) || !r->file)
+	{
+		return;
+	}
+
+	subscribe_entry s;
+	uint64_t length = r->length < AE_LOG_ENTRY_MESSAGE_SIZE ? r->length : AE_LOG_ENTRY_MESSAGE_SIZE - 1;
+	uint64_t sequence = i_ae_atomic_load_relaxed(&s_head);
+
+	s.entry.sequence = sequence;
+	s.entry.lost = 0;
+	s.entry.time = r->time;
+	s.entry.file = r->file;
+	s.entry.line = r->line;
+	s.entry.level = r->level;
+	s.entry.length = (uint32_t)length;
+	s.entry.truncated = length < r->length;
+	s.entry.thread = r->thread;
+	s.entry.thread_sequence = r->sequence;
+
+	memset(s.entry.thread_name, 0, AE_LOG_THREAD_NAME_SIZE);
+
+	if (r->thread_name)
+	{
+		memcpy(s.entry.thread_name, r->thread_name, (size_t)strnlen(r->thread_name, AE_LOG_THREAD_NAME_SIZE - 1));
+	}
+
+	memcpy(s.entry.message, r->message, (size_t)length);
+	memset(s.entry.message + length, 0, (size_t)(entry_words(length) * 8 - offsetof(ae_log_entry, message) - length));
+
+	subscribe_slot* slot = &s_ring[sequence & (AE_LOG_SUBSCRIBE_SLOTS - 1)];
+	uint64_t count = entry_words(length);
+
+	// Readers that see the odd version, or a version that changed while they copied, report a gap
+	i_ae_atomic_exchange(&slot->version, sequence * 2 + 1);
+
+	for (uint64_t i = 0; i < count; i++)
+	{
+		i_ae_atomic_store(&slot->words[i], s.words[i]);
+	}
+
+	i_ae_atomic_store(&slot->version, (sequence + 1) * 2);
+	i_ae_atomic_store(&s_head, sequence + 1);
+}
@@ -0,0 +1,87 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#ifdef AE_LINUX
+#define _GNU_SOURCE
+#endif // AE_LINUX
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <string.h>
+
+static AE_THREAD_LOCAL i_ae_thread_info t_info;
+static AE_THREAD_LOCAL int t_ready = 0;
+
+// Identity -----------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Reads the name the operating system has for the calling thread, or leaves it empty if it has none.
+/// </summary>
+static void thread_name_read(char* name)
+{
+	memset(name, 0, AE_LOG_THREAD_NAME_SIZE);
+
+#if defined(AE_WINDOWS)
+	PWSTR wide = NULL;
+
+	if (SUCCEEDED(GetThreadDescription(GetCurrentThread(), &wide)) && wide)
+	{
+		char utf8[AE_LOG_THREAD_NAME_SIZE * 4];
+		int n = WideCharToMultiByte(CP_UTF8, 0, wide, -1, utf8, (int)sizeof(utf8), NULL, NULL);
+
+		if (n > 0)
+		{
+			strncpy_s(name, AE_LOG_THREAD_NAME_SIZE, utf8, _TRUNCATE);
+		}
+
+		LocalFree(wide);
+	}
+#else
+	if (pthread_getname_np(pthread_self(), name, AE_LOG_THREAD_NAME_SIZE) != 0)
+	{
+		name[0] = '\0';
+	}
+#endif // AE_WINDOWS
+}
+
+i_ae_thread_info* i_ae_thread_info_get(void)
+{
+	if (!t_ready)
+	{
+		t_info.id = i_ae_thread_id();
+		t_info.sequence = 0;
+		thread_name_read(t_info.name);
+		t_info.context = &i_ae_context_none;
+
+		t_ready = 1;
+	}
+
+	return &t_info;
+}
+
+// Interface ----------------------------------------------------------------------------------------------------
+
+void ae_log_thread_name_set(const char* name)
+{
+	i_ae_thread_info* t = i_ae_thread_info_get();
+
+	if (!name)
+	{
+		thread_name_read(t->name);
+		return;
+	}
+
+	uint64_t length = strlen(name);
+
+	if (length >= AE_LOG_THREAD_NAME_SIZE)
+	{
+		length = AE_LOG_THREAD_NAME_SIZE - 1;
+	}
+
+	memset(t->name, 0, AE_LOG_THREAD_NAME_SIZE);
+	memcpy(t->name, name, (size_t)length);
+}
@@ -0,0 +1,219 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+// Each power of two is split into 16 buckets, so a percentile is off by at most 1/16 (6.25%)
+#define AE_TIMER_SUB_BITS 4
+#define AE_TIMER_SUB_BUCKETS (1 << AE_TIMER_SUB_BITS)
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+static i_ae_timer_site* s_sites = NULL;
+
+static double s_ns_per_tick = 0.0;
+
+static volatile uint64_t s_report_interval = 0;
+static volatile uint64_t s_report_next = UINT64_MAX;
+
+uint64_t i_ae_timer_ticks(void)
+{
+	return i_ae_time_monotonic();
+}
+
+static uint32_t highest_bit(uint64_t v)
+{
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanReverse64(&i, v);
+	return (uint32_t)i;
+#else
+	return 63 - (uint32_t)__builtin_clzll(v);
+#endif // _MSC_VER
+}
+
+static uint32_t timer_bucket(uint64_t ticks)
+{
+	if (ticks < AE_TIMER_SUB_BUCKETS)
+	{
+		return (uint32_t)ticks;
+	}
+
+	uint32_t e = highest_bit(ticks);
+	uint32_t sub = (uint32_t)(ticks >> (e - AE_TIMER_SUB_BITS)) & (AE_TIMER_SUB_BUCKETS - 1);
+
+	return (e - AE_TIMER_SUB_BITS + 1) * AE_TIMER_SUB_BUCKETS + sub;
+}
+
+/// <summary>
+/// Returns the middle of the range of ticks that a bucket holds.
+/// </summary>
+static uint64_t timer_bucket_value(uint32_t b)
+{
+	if (b < AE_TIMER_SUB_BUCKETS)
+	{
+		return b;
+	}
+
+	uint32_t shift = b / AE_TIMER_SUB_BUCKETS - 1;
+	uint64_t lower = (uint64_t)(AE_TIMER_SUB_BUCKETS + b % AE_TIMER_SUB_BUCKETS) << shift;
+
+	return lower + ((1ULL << shift) >> 1);
+}
+
+/// <summary>
+/// Measures the tick rate once. Must be called with s_mutex locked.
+/// </summary>
+static double timer_ns_per_tick(void)
+{
+	if (s_ns_per_tick == 0.0)
+	{
+		uint64_t ns = i_ae_time_monotonic();
+		uint64_t ticks = I_AE_TIMER_TICKS();
+
+		i_ae_sleep_us(10000);
+
+		uint64_t elapsed_ticks = I_AE_TIMER_TICKS() - ticks;
+		uint64_t elapsed_ns = i_ae_time_monotonic() - ns;
+
+		s_ns_per_tick = elapsed_ticks > 0 ? (double)elapsed_ns / (double)elapsed_ticks : 1.0;
+	}
+
+	return s_ns_per_tick;
+}
+
+static void timer_register(i_ae_timer_site* site)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	if (!site->registered)
+	{
+		site->next = s_sites;
+		s_sites = site;
+
+		i_ae_atomic_store(&site->registered, 1);
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+/// <summary>
+/// Writes the percentiles of a timer and empties its histogram. Must be called with s_mutex locked.
+/// </summary>
+static void timer_dump(i_ae_timer_site* site, double ns_per_tick)
+{
+	static uint64_t buckets[I_AE_TIMER_BUCKETS];
+	uint64_t count = 0;
+
+	// Timers that end while the histogram is being emptied are counted in the next dump
+	for (uint32_t i = 0; i < I_AE_TIMER_BUCKETS; i++)
+	{
+		buckets[i] = site->buckets[i] ? i_ae_atomic_exchange(&site->buckets[i], 0) : 0;
+		count += buckets[i];
+	}
+
+	uint64_t max = (uint64_t)((double)i_ae_atomic_exchange(&site->max, 0) * ns_per_tick);
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	const double percentiles[3] = { 0.50, 0.90, 0.99 };
+	uint64_t values[3] = { 0, 0, 0 };
+
+	uint64_t seen = 0;
+	uint32_t p = 0;
+
+	for (uint32_t i = 0; i < I_AE_TIMER_BUCKETS && p < 3; i++)
+	{
+		seen += buckets[i];
+
+		while (p < 3 && (double)seen >= percentiles[p] * (double)count)
+		{
+			uint64_t value = (uint64_t)((double)timer_bucket_value(i) * ns_per_tick);
+			values[p++] = value < max ? value : max;
+		}
+	}
+
+	i_ae_log_file(INFO, site->file, site->line, "Timer: %s | Count: %llu | p50: %llu ns | p90: %llu ns | p99: %llu ns | Max: %llu ns",
+		site->name, (unsigned long long)count, (unsigned long long)values[0], (unsigned long long)values[1],
+		(unsigned long long)values[2], (unsigned long long)max);
+}
+
+void i_ae_timer_end(i_ae_timer_scope* s)
+{
+	uint64_t end = I_AE_TIMER_TICKS();
+	uint64_t ticks = end > s->start ? end - s->start : 0;
+
+	i_ae_timer_site* site = s->site;
+
+	if (!site->registered)
+	{
+		timer_register(site);
+	}
+
+	i_ae_atomic_add(&site->buckets[timer_bucket(ticks)], 1);
+
+	uint64_t max = site->max;
+
+	while (ticks > max && !i_ae_atomic_cas(&site->max, max, ticks))
+	{
+		max = i_ae_atomic_load(&site->max);
+	}
+
+	uint64_t next = s_report_next;
+
+	// Only the timer that moves the deadline forward dumps
+	if (end >= next && i_ae_atomic_cas(&s_report_next, next, UINT64_MAX))
+	{
+		ae_log_timer_dump();
+	}
+}
+
+void ae_log_timer_dump(void)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	// The histograms are kept while the dump would be filtered out, so the next dump that is written covers them
+	if (s_sites && i_ae_log_file_enabled(NULL, INFO))
+	{
+		double ns_per_tick = timer_ns_per_tick();
+
+		for (i_ae_timer_site* site = s_sites; site; site = site->next)
+		{
+			timer_dump(site, ns_per_tick);
+		}
+	}
+
+	uint64_t interval = s_report_interval;
+
+	if (interval > 0)
+	{
+		i_ae_atomic_store(&s_report_next, I_AE_TIMER_TICKS() + (uint64_t)((double)interval / timer_ns_per_tick()));
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+void ae_log_timer_report_set(uint32_t interval)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	s_report_interval = (uint64_t)interval * 1000000;
+
+	if (interval > 0)
+	{
+		i_ae_atomic_store(&s_report_next, I_AE_TIMER_TICKS() + (uint64_t)((double)s_report_interval / timer_ns_per_tick()));
+	}
+
+	else
+	{
+		i_ae_atomic_store(&s_report_next, UINT64_MAX);
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
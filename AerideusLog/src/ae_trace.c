@@ -0,0 +1,428 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+*/
+
+#include "../include/aerideus_log.h"
+#include "../internal/ae_internal.h"
+#include "../internal/ae_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define AE_LOG_TRACE_BUFFER_SIZE 262144
+#define AE_LOG_TRACE_MESSAGE_SIZE (AE_LOG_TRACE_BUFFER_SIZE / 16)
+
+/// <summary>
+/// Header of an event in a trace buffer, immediately followed by the message of a log record. The size
+/// includes the header and is a multiple of 8. An event without a type is padding at the end of the buffer.
+/// </summary>
+typedef struct
+{
+	uint32_t size;
+	char type;
+	uint8_t level;
+	int32_t line;
+	uint32_t length;
+	const char* name;
+	uint64_t time;
+	uint64_t duration;
+} trace_event;
+
+/// <summary>
+/// Events of one thread in the order they happened. Written only by the owning thread and read when the
+/// trace is flushed. The head and tail are kept on separate cache lines.
+/// </summary>
+typedef struct trace_buffer
+{
+	volatile uint64_t head;
+	char padding_0[AE_CACHE_LINE - 8];
+
+	volatile uint64_t tail;
+	char padding_1[AE_CACHE_LINE - 8];
+
+	volatile uint64_t orphaned;
+	uint64_t thread;
+	struct trace_buffer* next;
+
+	char data[AE_LOG_TRACE_BUFFER_SIZE];
+} trace_buffer;
+
+static i_ae_mutex s_mutex = I_AE_MUTEX_INIT;
+static trace_buffer* s_buffers = NULL;
+static i_ae_tls_key s_key;
+static int s_key_created = 0;
+
+static volatile uint64_t s_open = 0;
+static FILE* s_file = NULL;
+static uint64_t s_origin = 0;
+static int s_first = 1;
+
+static AE_THREAD_LOCAL trace_buffer* t_buffer = NULL;
+
+static const char* s_labels[5] = { "TRACE", "INFO", "WARNING", "ERROR", "FATAL" };
+
+static uint64_t event_size(uint64_t length)
+{
+	return (sizeof(trace_event) + length + 7) & ~7ULL;
+}
+
+// Serialization ------------------------------------------------------------------------------------------------
+
+static void json_write_string(FILE* f, const char* s, uint64_t length)
+{
+	fputc('"', f);
+
+	for (uint64_t i = 0; i < length; i++)
+	{
+		unsigned char c = (unsigned char)s[i];
+
+		if (c == '"' || c == '\\')
+		{
+			fputc('\\', f);
+			fputc(c, f);
+		}
+
+		else if (c < 0x20)
+		{
+			fprintf(f, "\\u%04x", c);
+		}
+
+		else
+		{
+			fputc(c, f);
+		}
+	}
+
+	fputc('"', f);
+}
+
+static void event_write(const trace_buffer* b, const trace_event* e)
+{
+	uint64_t ts = e->time > s_origin ? e->time - s_origin : 0;
+
+	fputs(s_first ? "\n" : ",\n", s_file);
+	s_first = 0;
+
+	fputs("{\"name\":", s_file);
+
+	if (e->type == 'L')
+	{
+		json_write_string(s_file, (const char*)(e + 1), e->length);
+		fputs(",\"cat\":\"log\",\"ph\":\"i\",\"s\":\"t\"", s_file);
+	}
+
+	else
+	{
+		json_write_string(s_file, e->name, strlen(e->name));
+
+		if (e->type == 'I')
+		{
+			fputs(",\"cat\":\"instant\",\"ph\":\"i\",\"s\":\"t\"", s_file);
+		}
+
+		else
+		{
+			fprintf(s_file, ",\"cat\":\"span\",\"ph\":\"%c\"", e->type);
+		}
+	}
+
+	// Chrome expects microseconds, the fraction keeps nanosecond precision
+	fprintf(s_file, ",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%llu", (unsigned long long)(ts / 1000), (unsigned int)(ts % 1000),
+		i_ae_process_id(), (unsigned long long)b->thread);
+
+	if (e->type == 'X')
+	{
+		fprintf(s_file, ",\"dur\":%llu.%03u", (unsigned long long)(e->duration / 1000), (unsigned int)(e->duration % 1000));
+	}
+
+	else if (e->type == 'L')
+	{
+		fprintf(s_file, ",\"args\":{\"level\":\"%s\",\"file\":", s_labels[e->level]);
+		json_write_string(s_file, e->name, strlen(e->name));
+		fprintf(s_file, ",\"line\":%d}", e->line);
+	}
+
+	fputc('}', s_file);
+}
+
+/// <summary>
+/// Serializes the events of a buffer, or discards them if the trace is closed. Must be called with s_mutex locked.
+/// </summary>
+static void buffer_drain(trace_buffer* b)
+{
+	uint64_t tail = b->tail;
+	uint64_t head = i_ae_atomic_load(&b->head);
+
+	while (tail != head)
+	{
+		trace_event* e = (trace_event*)(b->data + (tail % AE_LOG_TRACE_BUFFER_SIZE));
+
+		if (e->type && s_file)
+		{
+			event_write(b, e);
+		}
+
+		tail += e->size;
+	}
+
+	i_ae_atomic_store(&b->tail, tail);
+}
+
+/// <summary>
+/// Serializes every buffer and frees the buffers of threads that have exited. Must be called with s_mutex locked.
+/// </summary>
+static void buffers_drain(void)
+{
+	trace_buffer** link = &s_buffers;
+
+	while (*link)
+	{
+		trace_buffer* b = *link;
+		buffer_drain(b);
+
+		if (i_ae_atomic_load(&b->orphaned) && b->tail == i_ae_atomic_load(&b->head))
+		{
+			*link = b->next;
+			free(b);
+		}
+
+		else
+		{
+			link = &b->next;
+		}
+	}
+}
+
+// Buffers ------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Called when a thread that owns a buffer exits. The buffer is freed once it has been serialized.
+/// </summary>
+static void buffer_release(void* p)
+{
+	trace_buffer* b = p;
+	i_ae_atomic_store(&b->orphaned, 1);
+
+	t_buffer = NULL;
+}
+
+static trace_buffer* buffer_attach(void)
+{
+	trace_buffer* b = malloc(sizeof(trace_buffer));
+
+	if (!b)
+	{
+		return NULL;
+	}
+
+	b->head = 0;
+	b->tail = 0;
+	b->orphaned = 0;
+	b->thread = i_ae_thread_id();
+
+	i_ae_mutex_lock(&s_mutex);
+
+	if (!s_key_created)
+	{
+		s_key_created = i_ae_tls_key_create(&s_key, buffer_release);
+	}
+
+	if (!s_key_created)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+
+		free(b);
+		return NULL;
+	}
+
+	b->next = s_buffers;
+	s_buffers = b;
+
+	i_ae_mutex_unlock(&s_mutex);
+
+	i_ae_tls_set(s_key, b);
+
+	t_buffer = b;
+	return b;
+}
+
+static void trace_write(char type, const char* name, uint64_t time, uint64_t duration, const ae_record* r)
+{
+	trace_buffer* b = t_buffer ? t_buffer : buffer_attach();
+
+	if (!b)
+	{
+		return;
+	}
+
+	// Long messages are shortened so that a few of them never fill the buffer
+	uint64_t length = r ? (r->length < AE_LOG_TRACE_MESSAGE_SIZE ? r->length : AE_LOG_TRACE_MESSAGE_SIZE) : 0;
+	uint64_t needed = event_size(length);
+	uint64_t head;
+	uint64_t offset;
+
+	for (;;)
+	{
+		head = b->head;
+		offset = head % AE_LOG_TRACE_BUFFER_SIZE;
+
+		uint64_t used = head - i_ae_atomic_load(&b->tail);
+		uint64_t contiguous = AE_LOG_TRACE_BUFFER_SIZE - offset;
+
+		// Events never wrap, the end of the buffer is skipped with padding if the event does not fit
+		if (contiguous < needed && used + contiguous + needed <= AE_LOG_TRACE_BUFFER_SIZE)
+		{
+			trace_event* padding = (trace_event*)(b->data + offset);
+			padding->size = (uint32_t)contiguous;
+			padding->type = 0;
+
+			head += contiguous;
+			offset = 0;
+			break;
+		}
+
+		else if (contiguous >= needed && used + needed <= AE_LOG_TRACE_BUFFER_SIZE)
+		{
+			break;
+		}
+
+		// The buffer is full, the thread serializes it instead of waiting for the next flush
+		i_ae_mutex_lock(&s_mutex);
+		buffer_drain(b);
+		i_ae_mutex_unlock(&s_mutex);
+	}
+
+	trace_event* e = (trace_event*)(b->data + offset);
+
+	e->size = (uint32_t)needed;
+	e->type = type;
+	e->level = r ? (uint8_t)r->level : 0;
+	e->line = r ? r->line : 0;
+	e->length = (uint32_t)length;
+	e->name = name;
+	e->time = time;
+	e->duration = duration;
+
+	if (r)
+	{
+		memcpy(e + 1, r->message, (size_t)length);
+	}
+
+	i_ae_atomic_store(&b->head, head + needed);
+}
+
+// Interface ----------------------------------------------------------------------------------------------------
+
+int ae_log_trace_open(const char* path)
+{
+	ae_log_trace_close();
+
+	if (!path)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to open trace file because the specified path is NULL.");
+		return 0;
+	}
+
+	i_ae_mutex_lock(&s_mutex);
+
+	FILE* f;
+	fopen_s(&f, path, "w");
+
+	if (!f)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+
+		AE_LOG_CONSOLE_ERROR("Failed to open trace file because the specified path is incorrect. Make sure that the specified path is in a directory that exists.");
+		return 0;
+	}
+
+	// Events that were written while no trace was open are discarded
+	buffers_drain();
+
+	s_file = f;
+	s_origin = i_ae_time_now();
+	s_first = 1;
+
+	fputs("{\"traceEvents\":[", s_file);
+
+	i_ae_atomic_store(&s_open, 1);
+
+	i_ae_mutex_unlock(&s_mutex);
+	return 1;
+}
+
+void ae_log_trace_flush(void)
+{
+	if (!s_open)
+	{
+		return;
+	}
+
+	i_ae_mutex_lock(&s_mutex);
+
+	if (s_file)
+	{
+		buffers_drain();
+		fflush(s_file);
+	}
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+void ae_log_trace_close(void)
+{
+	i_ae_mutex_lock(&s_mutex);
+
+	if (!s_file)
+	{
+		i_ae_mutex_unlock(&s_mutex);
+		return;
+	}
+
+	i_ae_atomic_store(&s_open, 0);
+
+	buffers_drain();
+
+	char origin[48];
+	i_ae_time_render(s_origin, origin, sizeof(origin));
+
+	fprintf(s_file, "\n],\"otherData\":{\"origin\":\"%s\"}}\n", origin);
+	fclose(s_file);
+
+	s_file = NULL;
+
+	i_ae_mutex_unlock(&s_mutex);
+}
+
+// Spans are timed with the monotonic clock so that a step of the system clock can not make them negative, the
+// wall-clock start is worked out from the duration when the span ends
+uint64_t i_ae_trace_span_begin(void)
+{
+	return s_open ? i_ae_time_monotonic() : 0;
+}
+
+void i_ae_trace_span_end(i_ae_trace_span* s)
+{
+	if (s_open && s->start != 0)
+	{
+		uint64_t duration = i_ae_time_monotonic() - s->start;
+		trace_write('X', s->name, i_ae_time_now() - duration, duration, NULL);
+	}
+}
+
+void i_ae_trace_event(char type, const char* name)
+{
+	if (s_open)
+	{
+		trace_write(type, name, i_ae_time_now(), 0, NULL);
+	}
+}
+
+void i_ae_log_trace_write(const ae_record* r)
+{
+	if (s_open && r->file)
+	{
+		trace_write('L', r->file, r->time, 0, r);
+	}
+}
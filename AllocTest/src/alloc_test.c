@@ -0,0 +1,232 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+
+	Aerideus Log AllocTest checks that logging does not allocate memory once it has
+	been set up. It replaces malloc and free, sets up file logging with reserved
+	memory, lets every thread log once, and then counts allocations while several
+	threads log as fast as they can, first synchronously and then asynchronously.
+	Every hundredth message is longer than the message buffer. The test fails if
+	anything was allocated.
+
+	Usage: AllocTest [threads] [messages per thread]
+
+	Replacing the allocator requires glibc, on other platforms and in the sanitizer
+	configurations, which replace the allocator themselves, the test is skipped.
+
+	Copyright (c) 2023 Aerideus
+*/
+
+#include "aerideus_log.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(AE_LINUX) && defined(__GLIBC__) && !defined(AE_SANITIZE)
+
+#include <pthread.h>
+
+#define ALLOC_TEST_MAX_THREADS 64
+
+// Longer than the message buffer, so that the message is formatted straight into the log file
+#define ALLOC_TEST_LONG_SIZE 3000
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* p, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* p);
+
+static volatile int s_counting = 0;
+static volatile uint64_t s_allocations = 0;
+static volatile uint64_t s_frees = 0;
+
+static pthread_barrier_t s_barrier;
+static int s_messages = 0;
+
+static char s_long[ALLOC_TEST_LONG_SIZE + 1];
+
+// Allocator ----------------------------------------------------------------------------------------------------
+
+static void count(volatile uint64_t* counter)
+{
+	if (s_counting)
+	{
+		__atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+	}
+}
+
+void* malloc(size_t size)
+{
+	count(&s_allocations);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count_, size_t size)
+{
+	count(&s_allocations);
+	return __libc_calloc(count_, size);
+}
+
+void* realloc(void* p, size_t size)
+{
+	count(&s_allocations);
+	return __libc_realloc(p, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+	count(&s_allocations);
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** p, size_t alignment, size_t size)
+{
+	count(&s_allocations);
+	*p = __libc_memalign(alignment, size);
+
+	return *p ? 0 : 12;
+}
+
+void free(void* p)
+{
+	if (p)
+	{
+		count(&s_frees);
+	}
+
+	__libc_free(p);
+}
+
+// Test ---------------------------------------------------------------------------------------------------------
+
+static void* storm(void* arg)
+{
+	long id = (long)arg;
+
+	// The first message of a thread sets up its buffers, which is allowed to allocate
+	AE_LOG_FILE_TRACE("Thread %ld started.", id);
+
+	{
+		AE_LOG_SCOPE_TIMER("warmup");
+	}
+
+	pthread_barrier_wait(&s_barrier);
+	pthread_barrier_wait(&s_barrier);
+
+	for (int i = 0; i < s_messages; i++)
+	{
+		AE_LOG_SCOPE_TIMER("message");
+		AE_LOG_FILE_INFO("Thread %ld message %d with a value of %.3f.", id, i, (double)i * 0.5);
+
+		if (i % 1000 == 0)
+		{
+			AE_LOG_FILE_WARNING("Thread %ld passed %d messages.", id, i);
+		}
+
+		if (i % 100 == 0)
+		{
+			AE_LOG_FILE_INFO("Thread %ld message %d with a long text: %s", id, i, s_long);
+		}
+	}
+
+	pthread_barrier_wait(&s_barrier);
+	return NULL;
+}
+
+/// <summary>
+/// Runs one storm and returns the number of allocations made while the threads were logging.
+/// </summary>
+static uint64_t run(int threads)
+{
+	pthread_t handles[ALLOC_TEST_MAX_THREADS];
+	pthread_barrier_init(&s_barrier, NULL, (unsigned int)threads + 1);
+
+	for (long i = 0; i < threads; i++)
+	{
+		pthread_create(&handles[i], NULL, storm, (void*)i);
+	}
+
+	pthread_barrier_wait(&s_barrier);
+
+	s_allocations = 0;
+	s_frees = 0;
+	__atomic_store_n(&s_counting, 1, __ATOMIC_SEQ_CST);
+
+	pthread_barrier_wait(&s_barrier);
+	pthread_barrier_wait(&s_barrier);
+
+	__atomic_store_n(&s_counting, 0, __ATOMIC_SEQ_CST);
+
+	for (int i = 0; i < threads; i++)
+	{
+		pthread_join(handles[i], NULL);
+	}
+
+	pthread_barrier_destroy(&s_barrier);
+
+	return s_allocations + s_frees;
+}
+
+int main(int argc, char** argv)
+{
+	int threads = argc > 1 ? atoi(argv[1]) : 4;
+	s_messages = argc > 2 ? atoi(argv[2]) : 20000;
+
+	if (threads < 1 || threads > ALLOC_TEST_MAX_THREADS || s_messages < 1)
+	{
+		AE_LOG_CONSOLE_ERROR("Usage: AllocTest [threads (1-%d)] [messages per thread]", ALLOC_TEST_MAX_THREADS);
+		return 1;
+	}
+
+	for (int i = 0; i < ALLOC_TEST_LONG_SIZE; i++)
+	{
+		s_long[i] = (char)('a' + i % 26);
+	}
+
+	// Room for both storms with margin, a message is about 120 bytes and every hundredth about 3 KB
+	uint64_t reserve = (uint64_t)threads * (uint64_t)s_messages * (256 + 64) * 2;
+
+	if (!AE_LOG_FILE_RESERVE(reserve))
+	{
+		return 1;
+	}
+
+	AE_LOG_CONSOLE_INFO("Logging %d messages from each of %d threads.", s_messages, threads);
+
+	uint64_t sync = run(threads);
+
+	ae_log_async_config config = { (uint32_t)threads, 1 << 20, 10000, 0, ERROR, 64 << 10, 20000, 50 };
+
+	if (!AE_LOG_FILE_ASYNC_START(&config))
+	{
+		return 1;
+	}
+
+	uint64_t async = run(threads);
+
+	AE_LOG_FILE_ASYNC_STOP();
+
+	AE_LOG_CONSOLE_INFO("Synchronous: %llu allocations.", (unsigned long long)sync);
+	AE_LOG_CONSOLE_INFO("Asynchronous: %llu allocations.", (unsigned long long)async);
+
+	if (sync > 0 || async > 0)
+	{
+		AE_LOG_CONSOLE_FATAL("Logging allocated memory after setup.");
+		return 1;
+	}
+
+	AE_LOG_CONSOLE_INFO("Passed.");
+	return 0;
+}
+
+#else
+
+int main(void)
+{
+	AE_LOG_CONSOLE_WARNING("AllocTest requires glibc without a sanitizer and was skipped.");
+	return 0;
+}
+
+#endif // AE_LINUX && __GLIBC__ && !AE_SANITIZE
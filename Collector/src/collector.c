@@ -0,0 +1,385 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+
+	Aerideus Log Collector drains the shared-memory rings that processes open with
+	AE_LOG_SHM_OPEN(name, slots) and writes their records as one merged log, ordered
+	by time. Rings of processes that have exited are drained and then unlinked, so
+	records written by a crashed process are still collected.
+
+	Usage: Collector <name> <output path> [--once] [--window <ms>] [pid ...]
+
+	On Linux, rings are discovered automatically in /dev/shm. On MacOS shared memory
+	can not be listed and the process ids must be specified.
+
+	Copyright (c) 2023 Aerideus
+*/
+
+#include "aerideus_log.h"
+#include "ae_platform.h"
+#include "ae_shm.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define AE_COLLECTOR_MAX_RINGS 1024
+
+// A slot that a dead process reserved but never published is skipped after this time
+#define AE_COLLECTOR_TORN_TIMEOUT 1000000000ULL
+
+typedef struct
+{
+	ae_shm_header* header;
+	uint64_t size;
+	uint64_t dropped;
+	uint64_t stuck_since;
+	char name[256];
+} ring;
+
+static ring s_rings[AE_COLLECTOR_MAX_RINGS];
+static int s_ring_count = 0;
+
+static volatile sig_atomic_t s_running = 1;
+
+static const char* s_labels[5] = { "TRACE", "INFO", "WARNING", "ERROR", "FATAL" };
+
+static void on_signal(int s)
+{
+	(void)s;
+	s_running = 0;
+}
+
+static int process_alive(int pid)
+{
+	return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+static void ring_open(const char* name)
+{
+	for (int i = 0; i < s_ring_count; i++)
+	{
+		if (strcmp(s_rings[i].name, name) == 0)
+		{
+			return;
+		}
+	}
+
+	if (s_ring_count == AE_COLLECTOR_MAX_RINGS)
+	{
+		return;
+	}
+
+	int fd = shm_open(name, O_RDWR, 0600);
+
+	if (fd < 0)
+	{
+		return;
+	}
+
+	struct stat st;
+
+	if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(ae_shm_header))
+	{
+		close(fd);
+		return;
+	}
+
+	void* p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (p == MAP_FAILED)
+	{
+		return;
+	}
+
+	ae_shm_header* h = p;
+
+	// Rings that are still being initialized are picked up on the next scan
+	if (i_ae_atomic_load(&h->magic) != AE_SHM_MAGIC || h->version != AE_SHM_VERSION || h->slot_size != sizeof(ae_shm_slot)
+		|| i_ae_shm_size(h->slot_count) != (uint64_t)st.st_size)
+	{
+		munmap(p, (size_t)st.st_size);
+		return;
+	}
+
+	ring* r = &s_rings[s_ring_count++];
+
+	r->header = h;
+	r->size = (uint64_t)st.st_size;
+	r->dropped = 0;
+	r->stuck_since = 0;
+	sprintf_s(r->name, sizeof(r->name), "%s", name);
+
+	AE_LOG_CONSOLE_INFO("Collecting %s (pid %d).", name, h->pid);
+}
+
+static void ring_close(int i)
+{
+	ring* r = &s_rings[i];
+
+	AE_LOG_CONSOLE_INFO("Finished collecting %s (pid %d).", r->name, r->header->pid);
+
+	munmap(r->header, r->size);
+	shm_unlink(r->name);
+
+	s_rings[i] = s_rings[--s_ring_count];
+}
+
+static void rings_discover(const char* name, int argc, char** argv, int first_pid)
+{
+	char path[512];
+
+	for (int i = first_pid; i < argc; i++)
+	{
+		sprintf_s(path, sizeof(path), "/%s-%s", name, argv[i]);
+		ring_open(path);
+	}
+
+#ifdef AE_LINUX
+	DIR* d = opendir("/dev/shm");
+
+	if (!d)
+	{
+		return;
+	}
+
+	size_t len = strlen(name);
+	struct dirent* e;
+
+	while ((e = readdir(d)))
+	{
+		if (strncmp(e->d_name, name, len) == 0 && e->d_name[len] == '-' && e->d_name[len + 1] >= '0' && e->d_name[len + 1] <= '9')
+		{
+			sprintf_s(path, sizeof(path), "/%s", e->d_name);
+			ring_open(path);
+		}
+	}
+
+	closedir(d);
+#endif // AE_LINUX
+}
+
+/// <summary>
+/// Returns the next published slot of a ring, or NULL if there is none. A slot that was reserved by a
+/// process that has since died is never published and is skipped once it has been stuck for a while.
+/// </summary>
+static ae_shm_slot* ring_peek(ring* r, uint64_t now)
+{
+	ae_shm_header* h = r->header;
+
+	for (;;)
+	{
+		uint64_t tail = h->tail;
+		ae_shm_slot* slot = i_ae_shm_slot(h, tail);
+
+		if (i_ae_atomic_load(&slot->sequence) == tail + 1)
+		{
+			r->stuck_since = 0;
+			return slot;
+		}
+
+		if (i_ae_atomic_load(&h->head) == tail || process_alive(h->pid))
+		{
+			r->stuck_since = 0;
+			return NULL;
+		}
+
+		if (r->stuck_since == 0)
+		{
+			r->stuck_since = now;
+			return NULL;
+		}
+
+		if (now - r->stuck_since < AE_COLLECTOR_TORN_TIMEOUT)
+		{
+			return NULL;
+		}
+
+		i_ae_atomic_store(&slot->sequence, tail + h->slot_count);
+		i_ae_atomic_store(&h->tail, tail + 1);
+		r->stuck_since = 0;
+	}
+}
+
+static void ring_pop(ring* r)
+{
+	ae_shm_header* h = r->header;
+	uint64_t tail = h->tail;
+
+	i_ae_atomic_store(&i_ae_shm_slot(h, tail)->sequence, tail + h->slot_count);
+	i_ae_atomic_store(&h->tail, tail + 1);
+}
+
+static void record_write(FILE* out, const ae_shm_header* h, const ae_shm_slot* slot)
+{
+	char time[48];
+	i_ae_time_render(slot->time, time, sizeof(time));
+
+	int level = slot->level >= TRACE && slot->level <= FATAL ? slot->level : FATAL;
+
+	// The lengths come from another process, they are read once and kept within the slot
+	uint32_t file_length = slot->file_length;
+	uint32_t message_length = slot->message_length;
+
+	file_length = file_length < sizeof(slot->data) ? file_length : (uint32_t)sizeof(slot->data);
+	message_length = message_length < sizeof(slot->data) - file_length ? message_length : (uint32_t)(sizeof(slot->data) - file_length);
+
+	fprintf_s(out, "%s [%s] %.*s | Line: %d | Pid: %d | Message: '%.*s'", time, s_labels[level], (int)file_length,
+		slot->data, slot->line, h->pid, (int)message_length, slot->data + file_length);
+
+	int name_length = (int)strnlen(slot->thread_name, sizeof(slot->thread_name));
+
+	if (name_length > 0)
+	{
+		fprintf_s(out, " | Thread: %.*s (%llu)", name_length, slot->thread_name, (unsigned long long)slot->thread);
+	}
+
+	else
+	{
+		fprintf_s(out, " | Thread: %llu", (unsigned long long)slot->thread);
+	}
+
+	fprintf_s(out, " | Sequence: %llu\n", (unsigned long long)slot->thread_sequence);
+}
+
+static void dropped_write(FILE* out, ring* r)
+{
+	uint64_t dropped = i_ae_atomic_load(&r->header->dropped);
+
+	if (dropped == r->dropped)
+	{
+		return;
+	}
+
+	char time[48];
+	i_ae_time_render(i_ae_time_now(), time, sizeof(time));
+
+	fprintf_s(out, "%s [WARNING] Collector | Pid: %d | Message: '%llu records were dropped because the ring was full'\n",
+		time, r->header->pid, (unsigned long long)(dropped - r->dropped));
+
+	r->dropped = dropped;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		AE_LOG_CONSOLE_ERROR("Usage: Collector <name> <output path> [--once] [--window <ms>] [pid ...]");
+		return 1;
+	}
+
+	const char* name = argv[1];
+	int once = 0;
+	uint64_t window = 50000000ULL;
+	int first_pid = 3;
+
+	while (first_pid < argc && strncmp(argv[first_pid], "--", 2) == 0)
+	{
+		if (strcmp(argv[first_pid], "--once") == 0)
+		{
+			once = 1;
+			first_pid++;
+		}
+
+		else if (strcmp(argv[first_pid], "--window") == 0 && first_pid + 1 < argc)
+		{
+			window = strtoull(argv[first_pid + 1], NULL, 10) * 1000000ULL;
+			first_pid += 2;
+		}
+
+		else
+		{
+			AE_LOG_CONSOLE_ERROR("Unknown option %s.", argv[first_pid]);
+			return 1;
+		}
+	}
+
+	FILE* out;
+	fopen_s(&out, argv[2], "a");
+
+	if (!out)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to open %s. Make sure that the specified path is in a directory that exists.", argv[2]);
+		return 1;
+	}
+
+	setvbuf(out, NULL, _IOFBF, 1 << 20);
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	uint64_t last_scan = 0;
+
+	for (;;)
+	{
+		uint64_t now = i_ae_time_now();
+		int draining = !s_running || once;
+
+		if (now - last_scan > 250000000ULL)
+		{
+			rings_discover(name, argc, argv, first_pid);
+			last_scan = now;
+		}
+
+		// K-way merge, the oldest published record of all rings is written first. A record is only written
+		// once it is older than the reorder window so that records still being published can be ordered
+		int written = 0;
+
+		for (;;)
+		{
+			ring* oldest = NULL;
+			ae_shm_slot* oldest_slot = NULL;
+
+			for (int i = 0; i < s_ring_count; i++)
+			{
+				ae_shm_slot* slot = ring_peek(&s_rings[i], now);
+
+				if (slot && (!oldest_slot || slot->time < oldest_slot->time))
+				{
+					oldest = &s_rings[i];
+					oldest_slot = slot;
+				}
+			}
+
+			if (!oldest || (!draining && oldest_slot->time + window > now))
+			{
+				break;
+			}
+
+			record_write(out, oldest->header, oldest_slot);
+			ring_pop(oldest);
+			written++;
+		}
+
+		for (int i = s_ring_count - 1; i >= 0; i--)
+		{
+			ring* r = &s_rings[i];
+			dropped_write(out, r);
+
+			if (i_ae_atomic_load(&r->header->head) == r->header->tail && !process_alive(r->header->pid))
+			{
+				ring_close(i);
+			}
+		}
+
+		if (written == 0)
+		{
+			fflush(out);
+
+			if (draining)
+			{
+				break;
+			}
+
+			usleep(1000);
+		}
+	}
+
+	fclose(out);
+	return 0;
+}
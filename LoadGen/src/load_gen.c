@@ -0,0 +1,727 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+
+	Aerideus Log LoadGen drives the logging macros with a load described by a profile,
+	so that changes to the logger can be measured with the same load on every build.
+	It reports the achieved throughput, percentiles of the time each logging call took
+	and the sink lag, the time from a call until its record reached the log file.
+
+	Usage: LoadGen [profile path] [seed]
+
+	The profile has the same 'key = value' format as the configuration file:
+
+	  threads = 4                  number of logging threads
+	  duration = 5                 seconds to log for
+	  seed = 1                     seed of the random generators, the seed argument overrides it
+	  burst = 100 20               threads only log during the first 20% of every 100 ms, at a
+	                               higher rate so that the average rate stays the same
+	  pace = on                    if off, every thread logs as fast as it can and the site rates
+	                               are only used as weights
+	  async = on                   asynchronous file logging with the default configuration
+	  output = loadgen.log         the log file is streamed to this path
+	  durability = none            none, periodic or group
+	  lag = on                     measures the sink lag with a subscriber that polls on its own core
+	  site = INFO int 10000        a callsite with a level, an argument shape and a rate in messages
+	                               per second per thread, up to 16 sites
+
+	The argument shapes are none, int, float, mixed and string:N for a string of N characters.
+	Without a profile a mix of five sites is logged by four threads for five seconds.
+
+	Copyright (c) 2023 Aerideus
+*/
+
+#include "aerideus_log.h"
+#include "ae_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LOADGEN_MAX_SITES 16
+#define LOADGEN_MAX_THREADS 256
+#define LOADGEN_MAX_STRING 4096
+
+// Latencies are counted in buckets of 32 per power of two, which keeps the error of a percentile below 3%
+#define LOADGEN_SUB_BITS 5
+#define LOADGEN_BUCKETS (64 << LOADGEN_SUB_BITS)
+
+// A thread that is further ahead of its schedule than this sleeps instead of spinning
+#define LOADGEN_SPIN_NS 100000
+
+enum
+{
+	SHAPE_NONE = 0, SHAPE_INT, SHAPE_FLOAT, SHAPE_MIXED, SHAPE_STRING
+};
+
+typedef struct
+{
+	log_level level;
+	int shape;
+	uint32_t length;
+	double rate;
+} site;
+
+typedef struct
+{
+	uint32_t threads;
+	double duration;
+	uint64_t seed;
+	uint32_t burst_period;
+	uint32_t burst_active;
+	int pace;
+	int async;
+	int lag;
+	ae_log_file_durability durability;
+	char output[256];
+	site sites[LOADGEN_MAX_SITES];
+	uint32_t site_count;
+} profile;
+
+typedef struct
+{
+	uint64_t counts[LOADGEN_BUCKETS];
+	uint64_t total;
+	uint64_t max;
+} histogram;
+
+typedef struct
+{
+	i_ae_thread thread;
+	uint32_t index;
+	uint64_t messages;
+	histogram latency;
+} worker;
+
+static profile s_profile;
+static worker* s_workers = NULL;
+static char s_string[LOADGEN_MAX_STRING + 1];
+
+static uint64_t s_start = 0;
+static uint64_t s_end = 0;
+
+static histogram s_lag;
+static uint64_t s_lost = 0;
+static volatile uint64_t s_stopping = 0;
+static i_ae_thread s_subscriber;
+
+static const char* s_labels[5] = { "TRACE", "INFO", "WARNING", "ERROR", "FATAL" };
+static const char* s_shapes[5] = { "none", "int", "float", "mixed", "string" };
+
+// Histogram ----------------------------------------------------------------------------------------------------
+
+static void histogram_add(histogram* h, uint64_t v)
+{
+	uint32_t i = (uint32_t)v;
+
+	if (v >= (1ULL << LOADGEN_SUB_BITS))
+	{
+		int msb = 63 - __builtin_clzll(v);
+		i = (uint32_t)(((msb - LOADGEN_SUB_BITS + 1) << LOADGEN_SUB_BITS) | ((v >> (msb - LOADGEN_SUB_BITS)) & ((1 << LOADGEN_SUB_BITS) - 1)));
+	}
+
+	h->counts[i]++;
+	h->total++;
+	h->max = v > h->max ? v : h->max;
+}
+
+static void histogram_merge(histogram* to, const histogram* from)
+{
+	for (uint32_t i = 0; i < LOADGEN_BUCKETS; i++)
+	{
+		to->counts[i] += from->counts[i];
+	}
+
+	to->total += from->total;
+	to->max = from->max > to->max ? from->max : to->max;
+}
+
+/// <summary>
+/// Returns the lower bound of the bucket that holds the given percentile.
+/// </summary>
+static uint64_t histogram_percentile(const histogram* h, double p)
+{
+	uint64_t rank = (uint64_t)((double)h->total * p / 100.0);
+	uint64_t seen = 0;
+
+	for (uint32_t i = 0; i < LOADGEN_BUCKETS; i++)
+	{
+		seen += h->counts[i];
+
+		if (seen > rank)
+		{
+			if (i < (1 << LOADGEN_SUB_BITS))
+			{
+				return i;
+			}
+
+			int msb = (int)(i >> LOADGEN_SUB_BITS) + LOADGEN_SUB_BITS - 1;
+			return (uint64_t)((1 << LOADGEN_SUB_BITS) | (i & ((1 << LOADGEN_SUB_BITS) - 1))) << (msb - LOADGEN_SUB_BITS);
+		}
+	}
+
+	return h->max;
+}
+
+// Profile ------------------------------------------------------------------------------------------------------
+
+static void profile_default(profile* p)
+{
+	memset(p, 0, sizeof(profile));
+
+	p->threads = 4;
+	p->duration = 5.0;
+	p->seed = 1;
+	p->burst_period = 100;
+	p->burst_active = 100;
+	p->pace = 1;
+	p->async = 1;
+	p->lag = 1;
+	p->durability = AE_LOG_FILE_DURABILITY_NONE;
+
+	sprintf_s(p->output, sizeof(p->output), "%s", "loadgen.log");
+}
+
+static void profile_default_sites(profile* p)
+{
+	p->sites[0] = (site){ INFO, SHAPE_INT, 0, 20000.0 };
+	p->sites[1] = (site){ TRACE, SHAPE_NONE, 0, 20000.0 };
+	p->sites[2] = (site){ INFO, SHAPE_STRING, 64, 5000.0 };
+	p->sites[3] = (site){ WARNING, SHAPE_MIXED, 0, 500.0 };
+	p->sites[4] = (site){ ERROR, SHAPE_FLOAT, 0, 10.0 };
+
+	p->site_count = 5;
+}
+
+static int parse_switch(const char* v, int* out)
+{
+	if (strcmp(v, "on") == 0 || strcmp(v, "off") == 0)
+	{
+		*out = strcmp(v, "on") == 0;
+		return 1;
+	}
+
+	return 0;
+}
+
+static int parse_site(char* v, site* s)
+{
+	char level[16];
+	char shape[32];
+	double rate;
+
+	if (sscanf(v, "%15s %31s %lf", level, shape, &rate) != 3 || rate < 0.0)
+	{
+		return 0;
+	}
+
+	s->level = (log_level)-1;
+
+	for (int i = 0; i < 5; i++)
+	{
+		if (strcmp(level, s_labels[i]) == 0)
+		{
+			s->level = (log_level)i;
+		}
+	}
+
+	s->shape = -1;
+	s->length = 0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (strcmp(shape, s_shapes[i]) == 0)
+		{
+			s->shape = i;
+		}
+	}
+
+	if (strncmp(shape, "string:", 7) == 0)
+	{
+		s->shape = SHAPE_STRING;
+		s->length = (uint32_t)strtoul(shape + 7, NULL, 10);
+	}
+
+	s->rate = rate;
+
+	return (int)s->level >= TRACE && (int)s->level <= FATAL && s->shape >= 0 && s->length <= LOADGEN_MAX_STRING;
+}
+
+static int profile_line(profile* p, char* key, char* value)
+{
+	if (strcmp(key, "threads") == 0)
+	{
+		p->threads = (uint32_t)strtoul(value, NULL, 10);
+		return p->threads > 0 && p->threads <= LOADGEN_MAX_THREADS;
+	}
+
+	else if (strcmp(key, "duration") == 0)
+	{
+		p->duration = strtod(value, NULL);
+		return p->duration > 0.0;
+	}
+
+	else if (strcmp(key, "seed") == 0)
+	{
+		p->seed = strtoull(value, NULL, 10);
+		return 1;
+	}
+
+	else if (strcmp(key, "burst") == 0)
+	{
+		return sscanf(value, "%u %u", &p->burst_period, &p->burst_active) == 2 && p->burst_period > 0
+			&& p->burst_active > 0 && p->burst_active <= 100;
+	}
+
+	else if (strcmp(key, "pace") == 0)
+	{
+		return parse_switch(value, &p->pace);
+	}
+
+	else if (strcmp(key, "async") == 0)
+	{
+		return parse_switch(value, &p->async);
+	}
+
+	else if (strcmp(key, "lag") == 0)
+	{
+		return parse_switch(value, &p->lag);
+	}
+
+	else if (strcmp(key, "output") == 0)
+	{
+		return sprintf_s(p->output, sizeof(p->output), "%s", value) < (int)sizeof(p->output);
+	}
+
+	else if (strcmp(key, "durability") == 0)
+	{
+		const char* names[3] = { "none", "periodic", "group" };
+
+		for (int i = 0; i < 3; i++)
+		{
+			if (strcmp(value, names[i]) == 0)
+			{
+				p->durability = (ae_log_file_durability)i;
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+
+	else if (strcmp(key, "site") == 0)
+	{
+		return p->site_count < LOADGEN_MAX_SITES && parse_site(value, &p->sites[p->site_count++]);
+	}
+
+	return 0;
+}
+
+static char* trim(char* s)
+{
+	while (*s == ' ' || *s == '\t')
+	{
+		s++;
+	}
+
+	char* end = s + strlen(s);
+
+	while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n'))
+	{
+		*--end = '\0';
+	}
+
+	return s;
+}
+
+static int profile_load(profile* p, const char* path)
+{
+	FILE* f;
+	fopen_s(&f, path, "r");
+
+	if (!f)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to open the profile %s.", path);
+		return 0;
+	}
+
+	char line[512];
+	int number = 0;
+
+	while (fgets(line, sizeof(line), f))
+	{
+		number++;
+
+		char* comment = strchr(line, '#');
+
+		if (comment)
+		{
+			*comment = '\0';
+		}
+
+		char* key = trim(line);
+
+		if (*key == '\0')
+		{
+			continue;
+		}
+
+		char* eq = strchr(key, '=');
+
+		if (eq)
+		{
+			*eq = '\0';
+		}
+
+		if (!eq || !profile_line(p, trim(key), trim(eq + 1)))
+		{
+			fclose(f);
+
+			AE_LOG_CONSOLE_ERROR("Invalid line %d in the profile %s.", number, path);
+			return 0;
+		}
+	}
+
+	fclose(f);
+	return 1;
+}
+
+// Sites --------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Defines a function with its own logging calls, so that each site of a profile is a callsite of its own.
+/// </summary>
+#define LOADGEN_SITE(n) \
+	static void site_##n(const site* s, uint64_t a, uint64_t b) \
+	{ \
+		switch (s->shape) \
+		{ \
+		case SHAPE_NONE: AE_LOG_FILE(s->level, "Static message without arguments."); break; \
+		case SHAPE_INT: AE_LOG_FILE(s->level, "Request %llu finished with status %d after %d us.", (unsigned long long)a, (int)(b % 600), (int)(b % 100000)); break; \
+		case SHAPE_FLOAT: AE_LOG_FILE(s->level, "Sensor %d read %.3f with a drift of %.6f.", (int)(a % 64), (double)b / 1e15, (double)(b % 1000) / 1e6); break; \
+		case SHAPE_MIXED: AE_LOG_FILE(s->level, "Job %s-%llx on worker %d is %.1f%% done (%c).", "import", (unsigned long long)b, (int)(a % 32), (double)(b % 1000) / 10.0, 'A' + (int)(a % 26)); break; \
+		default: AE_LOG_FILE(s->level, "User %.*s requested %s.", (int)s->length, s_string + (b % (LOADGEN_MAX_STRING + 1 - s->length)), "/index.html"); break; \
+		} \
+	}
+
+LOADGEN_SITE(0)
+LOADGEN_SITE(1)
+LOADGEN_SITE(2)
+LOADGEN_SITE(3)
+LOADGEN_SITE(4)
+LOADGEN_SITE(5)
+LOADGEN_SITE(6)
+LOADGEN_SITE(7)
+LOADGEN_SITE(8)
+LOADGEN_SITE(9)
+LOADGEN_SITE(10)
+LOADGEN_SITE(11)
+LOADGEN_SITE(12)
+LOADGEN_SITE(13)
+LOADGEN_SITE(14)
+LOADGEN_SITE(15)
+
+static void (*s_site_functions[LOADGEN_MAX_SITES])(const site*, uint64_t, uint64_t) = {
+	site_0, site_1, site_2, site_3, site_4, site_5, site_6, site_7,
+	site_8, site_9, site_10, site_11, site_12, site_13, site_14, site_15
+};
+
+// Threads ------------------------------------------------------------------------------------------------------
+
+static uint64_t random_next(uint64_t* x)
+{
+	*x ^= *x << 13;
+	*x ^= *x >> 7;
+	*x ^= *x << 17;
+
+	return *x;
+}
+
+/// <summary>
+/// Waits until the given monotonic time, spinning for the last part so that short intervals are kept.
+/// </summary>
+static uint64_t wait_until(uint64_t t)
+{
+	uint64_t now = i_ae_time_monotonic();
+
+	while (now < t)
+	{
+		if (t - now > LOADGEN_SPIN_NS)
+		{
+			i_ae_sleep_us((t - now - LOADGEN_SPIN_NS) / 1000);
+		}
+
+		now = i_ae_time_monotonic();
+	}
+
+	return now;
+}
+
+I_AE_THREAD_FUNCTION(worker_main, arg)
+{
+	worker* w = arg;
+	const profile* p = &s_profile;
+
+	// Every thread of every run makes the same choices for the same seed
+	uint64_t x = (p->seed + 1) * 0x9E3779B97F4A7C15ULL + w->index * 0xBF58476D1CE4E5B9ULL;
+	x = x ? x : 1;
+
+	double total = 0.0;
+	double limits[LOADGEN_MAX_SITES];
+
+	for (uint32_t i = 0; i < p->site_count; i++)
+	{
+		total += p->sites[i].rate;
+		limits[i] = total;
+	}
+
+	uint64_t period = (uint64_t)p->burst_period * 1000000ULL;
+	uint64_t active = period * p->burst_active / 100;
+
+	// The rate during a burst is raised so that the average over a period is the sum of the site rates
+	double interval = total > 0.0 ? 1e9 / (total * 100.0 / p->burst_active) : 0.0;
+	double next = (double)s_start;
+
+	for (;;)
+	{
+		uint64_t now;
+
+		if (p->pace)
+		{
+			uint64_t phase = ((uint64_t)next - s_start) % period;
+
+			if (phase >= active)
+			{
+				next += (double)(period - phase);
+			}
+
+			now = wait_until((uint64_t)next);
+			next += interval;
+		}
+
+		else
+		{
+			now = i_ae_time_monotonic();
+		}
+
+		if (now >= s_end)
+		{
+			break;
+		}
+
+		double pick = total > 0.0 ? (double)(random_next(&x) >> 11) / 9007199254740992.0 * total : 0.0;
+		uint32_t i = 0;
+
+		while (i + 1 < p->site_count && pick >= limits[i])
+		{
+			i++;
+		}
+
+		uint64_t a = random_next(&x);
+		uint64_t b = random_next(&x);
+
+		uint64_t t0 = i_ae_time_monotonic();
+		s_site_functions[i](&p->sites[i], a, b);
+		uint64_t t1 = i_ae_time_monotonic();
+
+		histogram_add(&w->latency, t1 - t0);
+		w->messages++;
+	}
+
+	I_AE_THREAD_RETURN;
+}
+
+I_AE_THREAD_FUNCTION(subscriber_main, arg)
+{
+	ae_log_cursor* c = arg;
+	ae_log_entry e;
+
+	for (;;)
+	{
+		if (!ae_log_cursor_poll(c, &e))
+		{
+			if (i_ae_atomic_load(&s_stopping))
+			{
+				break;
+			}
+
+			continue;
+		}
+
+		if (e.lost)
+		{
+			s_lost += e.lost;
+			continue;
+		}
+
+		uint64_t now = i_ae_time_now();
+		histogram_add(&s_lag, now > e.time ? now - e.time : 0);
+	}
+
+	I_AE_THREAD_RETURN;
+}
+
+// Report -------------------------------------------------------------------------------------------------------
+
+static const char* build_name(void)
+{
+#if defined(AE_DEBUG)
+	return "Debug";
+#elif defined(AE_RELEASE)
+	return "Release";
+#else
+	return "Dist";
+#endif
+}
+
+static void report(const char* name, double seconds)
+{
+	histogram latency;
+	memset(&latency, 0, sizeof(latency));
+
+	uint64_t messages = 0;
+
+	for (uint32_t i = 0; i < s_profile.threads; i++)
+	{
+		histogram_merge(&latency, &s_workers[i].latency);
+		messages += s_workers[i].messages;
+	}
+
+	double target = 0.0;
+
+	for (uint32_t i = 0; i < s_profile.site_count; i++)
+	{
+		target += s_profile.sites[i].rate * s_profile.threads;
+	}
+
+	ae_log_stats stats;
+	ae_log_stats_get(&stats);
+
+	AE_LOG_CONSOLE_INFO("Profile %s on a %s build with %u threads, seed %llu, async %s.", name, build_name(), s_profile.threads,
+		(unsigned long long)s_profile.seed, s_profile.async ? "on" : "off");
+
+	if (s_profile.pace)
+	{
+		AE_LOG_CONSOLE_INFO("Logged %llu messages in %.2f s, %.0f messages/s of a target of %.0f.", (unsigned long long)messages,
+			seconds, (double)messages / seconds, target);
+	}
+
+	else
+	{
+		AE_LOG_CONSOLE_INFO("Logged %llu messages in %.2f s, %.0f messages/s.", (unsigned long long)messages, seconds,
+			(double)messages / seconds);
+	}
+
+	AE_LOG_CONSOLE_INFO("Call time in ns: p50 %llu, p90 %llu, p99 %llu, p99.9 %llu, max %llu.",
+		(unsigned long long)histogram_percentile(&latency, 50.0), (unsigned long long)histogram_percentile(&latency, 90.0),
+		(unsigned long long)histogram_percentile(&latency, 99.0), (unsigned long long)histogram_percentile(&latency, 99.9),
+		(unsigned long long)latency.max);
+
+	if (s_profile.lag)
+	{
+		AE_LOG_CONSOLE_INFO("Sink lag in us: p50 %llu, p90 %llu, p99 %llu, p99.9 %llu, max %llu, %llu records not measured.",
+			(unsigned long long)histogram_percentile(&s_lag, 50.0) / 1000, (unsigned long long)histogram_percentile(&s_lag, 90.0) / 1000,
+			(unsigned long long)histogram_percentile(&s_lag, 99.0) / 1000, (unsigned long long)histogram_percentile(&s_lag, 99.9) / 1000,
+			(unsigned long long)s_lag.max / 1000, (unsigned long long)s_lost);
+	}
+
+	AE_LOG_CONSOLE_INFO("Dropped %llu messages, wrote %.1f MB.", (unsigned long long)stats.dropped, (double)stats.bytes / 1e6);
+}
+
+int main(int argc, char** argv)
+{
+	profile_default(&s_profile);
+
+	if (argc > 1 && !profile_load(&s_profile, argv[1]))
+	{
+		return 1;
+	}
+
+	if (s_profile.site_count == 0)
+	{
+		profile_default_sites(&s_profile);
+	}
+
+	if (argc > 2)
+	{
+		s_profile.seed = strtoull(argv[2], NULL, 10);
+	}
+
+	for (uint32_t i = 0; i < LOADGEN_MAX_STRING; i++)
+	{
+		s_string[i] = (char)('a' + i % 26);
+	}
+
+	s_workers = calloc(s_profile.threads, sizeof(worker));
+
+	if (!s_workers)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to allocate memory for %u threads.", s_profile.threads);
+		return 1;
+	}
+
+	AE_LOG_FILE_LEVEL_SET(TRACE);
+
+	ae_log_file_stream_config stream = { s_profile.durability, 100, 0 };
+
+	if (!AE_LOG_FILE_STREAM_OPEN(s_profile.output, &stream))
+	{
+		return 1;
+	}
+
+	if (s_profile.async && !AE_LOG_FILE_ASYNC_START(NULL))
+	{
+		return 1;
+	}
+
+	ae_log_cursor* cursor = NULL;
+
+	if (s_profile.lag)
+	{
+		cursor = AE_LOG_SUBSCRIBE();
+
+		if (!cursor || !i_ae_thread_create(&s_subscriber, subscriber_main, cursor))
+		{
+			AE_LOG_CONSOLE_ERROR("Failed to start the subscriber that measures the sink lag.");
+			return 1;
+		}
+	}
+
+	// Threads start a little later so that they all start at the same time
+	s_start = i_ae_time_monotonic() + 10000000ULL;
+	s_end = s_start + (uint64_t)(s_profile.duration * 1e9);
+
+	for (uint32_t i = 0; i < s_profile.threads; i++)
+	{
+		s_workers[i].index = i;
+
+		if (!i_ae_thread_create(&s_workers[i].thread, worker_main, &s_workers[i]))
+		{
+			AE_LOG_CONSOLE_ERROR("Failed to start thread %u.", i);
+			return 1;
+		}
+	}
+
+	for (uint32_t i = 0; i < s_profile.threads; i++)
+	{
+		i_ae_thread_join(s_workers[i].thread);
+	}
+
+	double seconds = (double)(i_ae_time_monotonic() - s_start) / 1e9;
+
+	AE_LOG_FILE_ASYNC_STOP();
+
+	if (cursor)
+	{
+		i_ae_atomic_store(&s_stopping, 1);
+		i_ae_thread_join(s_subscriber);
+
+		AE_LOG_UNSUBSCRIBE(cursor);
+	}
+
+	AE_LOG_FILE_STREAM_CLOSE();
+
+	report(argc > 1 ? argv[1] : "default", seconds);
+
+	free(s_workers);
+	return 0;
+}
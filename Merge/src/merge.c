@@ -0,0 +1,436 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+
+	Aerideus Log Merge combines log files written by this library, such as one file per
+	thread or per process, into one log ordered by time. The files are memory-mapped and
+	merged a record at a time, so files larger than the memory of the machine can be
+	merged. Text files, JSON Lines files and the output of the Collector can be mixed.
+
+	Usage: Merge <output path | -> <input path> [input path ...]
+
+	A record is a line that starts with a timestamp, or a JSON object with "time" as its
+	first field, together with the lines that follow it without one. Records of the same
+	file keep their order, and records with the same time are taken from the first file
+	on the command line first.
+
+	Copyright (c) 2023 Aerideus
+*/
+
+#include "aerideus_log.h"
+#include "ae_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define AE_MERGE_OUTPUT_SIZE (4 << 20)
+
+// Pages of an input that have been merged are given back in steps of this size so that the page cache is not
+// filled with files that are larger than memory
+#define AE_MERGE_RELEASE_SIZE (64ULL << 20)
+
+// The length of '2026-10-18T12:00:00.000000Z'
+#define AE_MERGE_TIME_LENGTH 27
+
+typedef struct
+{
+	const char* data;
+	uint64_t size;
+	uint64_t begin;
+	uint64_t end;
+	uint64_t key;
+	uint64_t next_key;
+	uint64_t released;
+	const char* path;
+} source;
+
+static source* s_sources = NULL;
+static int* s_heap = NULL;
+static int s_heap_count = 0;
+
+static int s_out = -1;
+static char* s_buffer = NULL;
+static uint64_t s_buffer_used = 0;
+static uint64_t s_page_size = 4096;
+
+// Output -------------------------------------------------------------------------------------------------------
+
+static int write_all(const char* data, uint64_t size)
+{
+	while (size > 0)
+	{
+		ssize_t n = write(s_out, data, (size_t)size);
+
+		if (n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if (n <= 0)
+		{
+			return 0;
+		}
+
+		data += n;
+		size -= (uint64_t)n;
+	}
+
+	return 1;
+}
+
+static int output_flush(void)
+{
+	int ok = write_all(s_buffer, s_buffer_used);
+	s_buffer_used = 0;
+
+	return ok;
+}
+
+static int output_write(const char* data, uint64_t size)
+{
+	if (s_buffer_used + size > AE_MERGE_OUTPUT_SIZE && !output_flush())
+	{
+		return 0;
+	}
+
+	// A record that is larger than the buffer is written straight from the mapped input
+	if (size > AE_MERGE_OUTPUT_SIZE)
+	{
+		return write_all(data, size);
+	}
+
+	memcpy(s_buffer + s_buffer_used, data, (size_t)size);
+	s_buffer_used += size;
+
+	return 1;
+}
+
+// Records ------------------------------------------------------------------------------------------------------
+
+static int digits(const char* p, int count, uint64_t* value)
+{
+	uint64_t v = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		if (p[i] < '0' || p[i] > '9')
+		{
+			return 0;
+		}
+
+		v = v * 10 + (uint64_t)(p[i] - '0');
+	}
+
+	*value = v;
+	return 1;
+}
+
+/// <summary>
+/// Reads the timestamp that a record starts with. The fields are packed into bits in the same order as they
+/// are written, so that keys compare like the times they were parsed from. Returns 0 for a line that does not
+/// start a record.
+/// </summary>
+static int line_key(const char* p, uint64_t n, uint64_t* key)
+{
+	if (n >= 9 && memcmp(p, "{\"time\":\"", 9) == 0)
+	{
+		p += 9;
+		n -= 9;
+	}
+
+	if (n < AE_MERGE_TIME_LENGTH || p[4] != '-' || p[7] != '-' || p[10] != 'T' || p[13] != ':' || p[16] != ':'
+		|| p[19] != '.' || p[26] != 'Z')
+	{
+		return 0;
+	}
+
+	uint64_t year, month, day, hour, minute, second, micro;
+
+	if (!digits(p, 4, &year) || !digits(p + 5, 2, &month) || !digits(p + 8, 2, &day) || !digits(p + 11, 2, &hour)
+		|| !digits(p + 14, 2, &minute) || !digits(p + 17, 2, &second) || !digits(p + 20, 6, &micro))
+	{
+		return 0;
+	}
+
+	*key = year << 46 | month << 42 | day << 37 | hour << 32 | minute << 26 | second << 20 | micro;
+	return 1;
+}
+
+static uint64_t line_end(const source* s, uint64_t offset)
+{
+	const char* nl = memchr(s->data + offset, '\n', (size_t)(s->size - offset));
+	return nl ? (uint64_t)(nl - s->data) + 1 : s->size;
+}
+
+/// <summary>
+/// Gives the pages before the current record back to the operating system once enough of them have been merged.
+/// </summary>
+static void source_release(source* s)
+{
+	if (s->begin - s->released < AE_MERGE_RELEASE_SIZE)
+	{
+		return;
+	}
+
+	uint64_t end = s->begin & ~(s_page_size - 1);
+
+	madvise((void*)(s->data + s->released), (size_t)(end - s->released), MADV_DONTNEED);
+	s->released = end;
+}
+
+/// <summary>
+/// Moves a source to its next record. Returns 0 when the source has no more records.
+/// </summary>
+static int source_next(source* s)
+{
+	s->begin = s->end;
+
+	if (s->begin >= s->size)
+	{
+		return 0;
+	}
+
+	s->key = s->next_key;
+	s->end = line_end(s, s->begin);
+
+	// Messages with line breaks, and blank lines, belong to the record before them. The key of the line that
+	// ends the record is kept for the next record
+	uint64_t key = 0;
+
+	while (s->end < s->size && !line_key(s->data + s->end, s->size - s->end, &key))
+	{
+		s->end = line_end(s, s->end);
+	}
+
+	s->next_key = key;
+
+	source_release(s);
+	return 1;
+}
+
+static int source_open(source* s, const char* path)
+{
+	s->path = path;
+	s->data = NULL;
+	s->size = 0;
+	s->begin = 0;
+	s->end = 0;
+	s->next_key = 0;
+	s->released = 0;
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to open %s.", path);
+		return 0;
+	}
+
+	struct stat st;
+
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+
+		AE_LOG_CONSOLE_ERROR("Failed to read the size of %s.", path);
+		return 0;
+	}
+
+	// An empty file has no records and can not be mapped
+	if (st.st_size == 0)
+	{
+		close(fd);
+		return 1;
+	}
+
+	void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (p == MAP_FAILED)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to map %s.", path);
+		return 0;
+	}
+
+	madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	s->data = p;
+	s->size = (uint64_t)st.st_size;
+
+	// Lines before the first timestamp of a file are kept in front of everything else
+	uint64_t key;
+	s->next_key = line_key(s->data, s->size, &key) ? key : 0;
+
+	return 1;
+}
+
+// Heap ---------------------------------------------------------------------------------------------------------
+
+static int source_before(int a, int b)
+{
+	const source* x = &s_sources[a];
+	const source* y = &s_sources[b];
+
+	return x->key < y->key || (x->key == y->key && a < b);
+}
+
+static void heap_down(int i)
+{
+	for (;;)
+	{
+		int l = 2 * i + 1;
+		int r = l + 1;
+		int m = i;
+
+		if (l < s_heap_count && source_before(s_heap[l], s_heap[m]))
+		{
+			m = l;
+		}
+
+		if (r < s_heap_count && source_before(s_heap[r], s_heap[m]))
+		{
+			m = r;
+		}
+
+		if (m == i)
+		{
+			return;
+		}
+
+		int t = s_heap[i];
+		s_heap[i] = s_heap[m];
+		s_heap[m] = t;
+
+		i = m;
+	}
+}
+
+static void heap_build(int count)
+{
+	s_heap_count = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		if (source_next(&s_sources[i]))
+		{
+			s_heap[s_heap_count++] = i;
+		}
+	}
+
+	for (int i = s_heap_count / 2 - 1; i >= 0; i--)
+	{
+		heap_down(i);
+	}
+}
+
+// Merge --------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		AE_LOG_CONSOLE_ERROR("Usage: Merge <output path | -> <input path> [input path ...]");
+		return 1;
+	}
+
+	int count = argc - 2;
+
+	s_sources = calloc((size_t)count, sizeof(source));
+	s_heap = malloc((size_t)count * sizeof(int));
+	s_buffer = malloc(AE_MERGE_OUTPUT_SIZE);
+
+	if (!s_sources || !s_heap || !s_buffer)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to allocate memory for %d files.", count);
+		return 1;
+	}
+
+	long page = sysconf(_SC_PAGESIZE);
+	s_page_size = page > 0 ? (uint64_t)page : 4096;
+
+	for (int i = 0; i < count; i++)
+	{
+		if (!source_open(&s_sources[i], argv[i + 2]))
+		{
+			return 1;
+		}
+	}
+
+	if (strcmp(argv[1], "-") == 0)
+	{
+		s_out = STDOUT_FILENO;
+	}
+
+	else
+	{
+		s_out = open(argv[1], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	}
+
+	if (s_out < 0)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to open %s. Make sure that the specified path is in a directory that exists.", argv[1]);
+		return 1;
+	}
+
+	uint64_t start = i_ae_time_monotonic();
+	uint64_t records = 0;
+	uint64_t bytes = 0;
+
+	heap_build(count);
+
+	while (s_heap_count > 0)
+	{
+		source* s = &s_sources[s_heap[0]];
+
+		if (!output_write(s->data + s->begin, s->end - s->begin))
+		{
+			AE_LOG_CONSOLE_ERROR("Failed to write to %s.", argv[1]);
+			return 1;
+		}
+
+		records++;
+		bytes += s->end - s->begin;
+
+		// The source stays at the top of the heap until a record of another source is older
+		if (!source_next(s))
+		{
+			s_heap[0] = s_heap[--s_heap_count];
+		}
+
+		heap_down(0);
+	}
+
+	if (!output_flush())
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to write to %s.", argv[1]);
+		return 1;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		if (s_sources[i].data)
+		{
+			munmap((void*)s_sources[i].data, (size_t)s_sources[i].size);
+		}
+	}
+
+	double seconds = (double)(i_ae_time_monotonic() - start) / 1e9;
+
+	// The console is the output when it is written to standard output
+	if (s_out != STDOUT_FILENO)
+	{
+		close(s_out);
+
+		AE_LOG_CONSOLE_INFO("Merged %llu records (%.1f MB) from %d files in %.2f s (%.1f MB/s).", (unsigned long long)records,
+			(double)bytes / 1e6, count, seconds, seconds > 0.0 ? (double)bytes / 1e6 / seconds : 0.0);
+	}
+
+	free(s_buffer);
+	free(s_heap);
+	free(s_sources);
+
+	return 0;
+}
@@ -0,0 +1,738 @@
+/*
+	Author: @rasmushugosson
+	Last modified: 2026-10-18
+
+	Aerideus Log StressTest checks that records are not lost, torn or interleaved when
+	many threads log at once. Every message carries the phase, thread and index it was
+	logged with, a payload that is derived from them and a checksum of the payload, so
+	that every record can be checked on its own. The threads log through every sink at
+	the same time: the log file, a subscriber, a shared-memory ring and a socket.
+
+	The threads log synchronously, then asynchronously and then asynchronously in
+	batches. Last, every message is an error that floods the priority lane of small
+	buffers that drop when full, half of them in batches. After each phase the log file is exported and read back, and it must hold
+	every message exactly once, in the order of its thread and with a gapless thread
+	sequence. The other sinks may drop messages, but the subscriber, the ring and the
+	socket must account for every message they did not deliver, and no sink may deliver
+	a message twice, out of order or damaged.
+
+	Usage: StressTest [threads] [messages per thread]
+
+	Build the ASan and TSan configurations to run the test under AddressSanitizer and
+	ThreadSanitizer.
+
+	Copyright (c) 2023 Aerideus
+*/
+
+#include "aerideus_log.h"
+#include "ae_platform.h"
+#include "ae_shm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define STRESS_MAX_THREADS 64
+#define STRESS_BATCH 32
+
+// Messages stay well below AE_LOG_ENTRY_MESSAGE_SIZE so that subscribers never receive a cut message
+#define STRESS_PAYLOAD_MIN 16
+#define STRESS_PAYLOAD_MAX 272
+#define STRESS_MESSAGE_MAX 512
+
+#define STRESS_SHM_SLOTS (1 << 16)
+#define STRESS_DATAGRAM_SIZE 65536
+
+enum
+{
+	PHASE_SYNC = 0, PHASE_ASYNC, PHASE_BATCH, PHASE_PRIORITY, PHASE_COUNT
+};
+
+static const char* s_phase_names[PHASE_COUNT] = { "sync", "async", "batch", "priority" };
+
+/// <summary>
+/// What a sink has delivered. Each tally is only written by the thread that reads its sink.
+/// </summary>
+typedef struct
+{
+	const char* name;
+
+	// Whether the thread sequences of the sink must be gapless or only increasing
+	int gapless;
+
+	uint8_t* seen;
+	int64_t* last_index;
+	uint64_t* last_sequence;
+
+	uint64_t received;
+	uint64_t lost;
+	uint64_t duplicated;
+	uint64_t corrupt;
+	uint64_t reordered;
+} tally;
+
+typedef struct
+{
+	i_ae_thread thread;
+	uint32_t phase;
+	uint32_t index;
+} worker;
+
+static uint32_t s_threads = 8;
+static uint32_t s_messages = 20000;
+
+static tally s_file = { "File", 1, NULL, NULL, NULL, 0, 0, 0, 0, 0 };
+static tally s_subscriber = { "Subscriber", 0, NULL, NULL, NULL, 0, 0, 0, 0, 0 };
+static tally s_shm = { "Shared memory", 0, NULL, NULL, NULL, 0, 0, 0, 0, 0 };
+static tally s_socket = { "Socket", 0, NULL, NULL, NULL, 0, 0, 0, 0, 0 };
+
+static volatile uint64_t s_stopping = 0;
+
+// Payload ------------------------------------------------------------------------------------------------------
+
+static uint32_t checksum(const char* p, uint64_t length)
+{
+	uint32_t h = 2166136261u;
+
+	for (uint64_t i = 0; i < length; i++)
+	{
+		h = (h ^ (uint8_t)p[i]) * 16777619u;
+	}
+
+	return h;
+}
+
+/// <summary>
+/// Writes the payload of a message, which only depends on where the message was logged, and returns its length.
+/// </summary>
+static uint32_t payload(char* out, uint32_t phase, uint32_t thread, uint32_t index)
+{
+	static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+	uint64_t x = ((uint64_t)phase << 56) ^ ((uint64_t)thread << 32) ^ index ^ 0x9E3779B97F4A7C15ULL;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+
+	uint32_t length = STRESS_PAYLOAD_MIN + (uint32_t)(x % (STRESS_PAYLOAD_MAX - STRESS_PAYLOAD_MIN + 1));
+
+	for (uint32_t i = 0; i < length; i++)
+	{
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+
+		out[i] = alphabet[x % (sizeof(alphabet) - 1)];
+	}
+
+	return length;
+}
+
+// Tally --------------------------------------------------------------------------------------------------------
+
+static int tally_create(tally* t)
+{
+	uint64_t streams = (uint64_t)PHASE_COUNT * s_threads;
+
+	t->seen = calloc(streams * s_messages, 1);
+	t->last_index = malloc(streams * sizeof(int64_t));
+	t->last_sequence = malloc(streams * sizeof(uint64_t));
+
+	if (!t->seen || !t->last_index || !t->last_sequence)
+	{
+		return 0;
+	}
+
+	for (uint64_t i = 0; i < streams; i++)
+	{
+		t->last_index[i] = -1;
+		t->last_sequence[i] = UINT64_MAX;
+	}
+
+	return 1;
+}
+
+static void tally_destroy(tally* t)
+{
+	free(t->seen);
+	free(t->last_index);
+	free(t->last_sequence);
+}
+
+/// <summary>
+/// Checks a delivered message. The sequence is the thread sequence of the record, or UINT64_MAX if the sink
+/// does not carry it.
+/// </summary>
+static void tally_add(tally* t, const char* message, uint64_t length, uint64_t sequence)
+{
+	char text[STRESS_MESSAGE_MAX];
+
+	if (length >= sizeof(text))
+	{
+		t->corrupt++;
+		return;
+	}
+
+	memcpy(text, message, (size_t)length);
+	text[length] = '\0';
+
+	unsigned int phase, thread, index, sum;
+	int start = 0;
+
+	if (sscanf(text, "stress %u %u %u %8x %n", &phase, &thread, &index, &sum, &start) != 4 || start == 0
+		|| phase >= PHASE_COUNT || thread >= s_threads || index >= s_messages)
+	{
+		t->corrupt++;
+		return;
+	}
+
+	// The payload must match its checksum and the payload that was logged
+	char expected[STRESS_PAYLOAD_MAX];
+	uint32_t expected_length = payload(expected, phase, thread, index);
+
+	const char* received = text + start;
+	uint64_t received_length = length - (uint64_t)start;
+
+	if (checksum(received, received_length) != sum || received_length != expected_length
+		|| memcmp(received, expected, expected_length) != 0)
+	{
+		t->corrupt++;
+		return;
+	}
+
+	uint64_t stream = (uint64_t)phase * s_threads + thread;
+	uint8_t* seen = &t->seen[stream * s_messages + index];
+
+	if (*seen)
+	{
+		t->duplicated++;
+		return;
+	}
+
+	*seen = 1;
+	t->received++;
+
+	if ((int64_t)index <= t->last_index[stream])
+	{
+		t->reordered++;
+	}
+
+	t->last_index[stream] = (int64_t)index;
+
+	if (sequence == UINT64_MAX)
+	{
+		return;
+	}
+
+	uint64_t last = t->last_sequence[stream];
+
+	if (t->gapless ? sequence != (last == UINT64_MAX ? 0 : last + 1) : (last != UINT64_MAX && sequence <= last))
+	{
+		t->reordered++;
+	}
+
+	t->last_sequence[stream] = sequence;
+}
+
+/// <summary>
+/// Reports a tally and returns 1 if it passed. A sink that must be complete may not have lost anything, and
+/// the losses of a sink that counts them must add up with what it delivered.
+/// </summary>
+static int tally_report(const tally* t, int complete, int counts_losses)
+{
+	uint64_t total = (uint64_t)PHASE_COUNT * s_threads * s_messages;
+
+	int passed = t->duplicated == 0 && t->corrupt == 0 && t->reordered == 0;
+
+	if (complete)
+	{
+		passed = passed && t->received == total;
+	}
+
+	else if (counts_losses)
+	{
+		passed = passed && t->received + t->lost == total;
+	}
+
+	if (counts_losses)
+	{
+		AE_LOG_CONSOLE(passed ? INFO : ERROR, "%s: %llu of %llu received, %llu lost, %llu duplicated, %llu corrupt, %llu out of order.",
+			t->name, (unsigned long long)t->received, (unsigned long long)total, (unsigned long long)t->lost,
+			(unsigned long long)t->duplicated, (unsigned long long)t->corrupt, (unsigned long long)t->reordered);
+	}
+
+	else
+	{
+		AE_LOG_CONSOLE(passed ? INFO : ERROR, "%s: %llu of %llu received, %llu duplicated, %llu corrupt, %llu out of order.",
+			t->name, (unsigned long long)t->received, (unsigned long long)total, (unsigned long long)t->duplicated,
+			(unsigned long long)t->corrupt, (unsigned long long)t->reordered);
+	}
+
+	return passed;
+}
+
+// Sinks --------------------------------------------------------------------------------------------------------
+
+/// <summary>
+/// Finds the message of a rendered line, which the payload never contains a quote in, and returns its length.
+/// </summary>
+static const char* line_message(const char* line, const char* end, uint64_t* length)
+{
+	static const char key[] = "Message: '";
+
+	for (const char* p = line; p + sizeof(key) - 1 <= end; p++)
+	{
+		if (memcmp(p, key, sizeof(key) - 1) == 0)
+		{
+			const char* message = p + sizeof(key) - 1;
+			const char* quote = memchr(message, '\'', (size_t)(end - message));
+
+			if (!quote)
+			{
+				return NULL;
+			}
+
+			*length = (uint64_t)(quote - message);
+			return message;
+		}
+	}
+
+	return NULL;
+}
+
+/// <summary>
+/// Reads an exported log file back into the file tally.
+/// </summary>
+static int file_check(const char* path)
+{
+	FILE* f = NULL;
+
+	if (fopen_s(&f, path, "rb") != 0 || !f)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to open the exported log file %s.", path);
+		return 0;
+	}
+
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	char* data = malloc((size_t)size + 1);
+
+	if (!data || fread(data, 1, (size_t)size, f) != (size_t)size)
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to read the exported log file %s.", path);
+
+		free(data);
+		fclose(f);
+		return 0;
+	}
+
+	fclose(f);
+
+	const char* end = data + size;
+
+	for (const char* line = data; line < end;)
+	{
+		const char* next = memchr(line, '\n', (size_t)(end - line));
+		next = next ? next : end;
+
+		uint64_t length;
+		const char* message = line_message(line, next, &length);
+
+		if (message)
+		{
+			static const char key[] = "| Sequence: ";
+			const char* after = message + length;
+			uint64_t sequence = UINT64_MAX;
+
+			for (const char* p = after; p + sizeof(key) - 1 <= next; p++)
+			{
+				if (memcmp(p, key, sizeof(key) - 1) == 0)
+				{
+					sequence = strtoull(p + sizeof(key) - 1, NULL, 10);
+					break;
+				}
+			}
+
+			tally_add(&s_file, message, length, sequence);
+		}
+
+		line = next + 1;
+	}
+
+	free(data);
+	return 1;
+}
+
+I_AE_THREAD_FUNCTION(subscriber_main, arg)
+{
+	ae_log_cursor* c = arg;
+	ae_log_entry e;
+
+	for (;;)
+	{
+		if (!AE_LOG_CURSOR_POLL(c, &e))
+		{
+			if (i_ae_atomic_load(&s_stopping))
+			{
+				break;
+			}
+
+			i_ae_yield();
+			continue;
+		}
+
+		if (e.lost)
+		{
+			s_subscriber.lost += e.lost;
+			continue;
+		}
+
+		if (e.truncated)
+		{
+			s_subscriber.corrupt++;
+			continue;
+		}
+
+		tally_add(&s_subscriber, e.message, e.length, e.thread_sequence);
+	}
+
+	I_AE_THREAD_RETURN;
+}
+
+/// <summary>
+/// Drains the shared-memory ring of the process the same way the Collector does.
+/// </summary>
+I_AE_THREAD_FUNCTION(shm_main, arg)
+{
+	ae_shm_header* h = arg;
+
+	for (;;)
+	{
+		uint64_t tail = h->tail;
+		ae_shm_slot* slot = i_ae_shm_slot(h, tail);
+
+		if (i_ae_atomic_load(&slot->sequence) != tail + 1)
+		{
+			if (i_ae_atomic_load(&s_stopping) && i_ae_atomic_load(&h->head) == tail)
+			{
+				break;
+			}
+
+			i_ae_yield();
+			continue;
+		}
+
+		tally_add(&s_shm, slot->data + slot->file_length, slot->message_length, slot->thread_sequence);
+
+		i_ae_atomic_store(&slot->sequence, tail + h->slot_count);
+		i_ae_atomic_store(&h->tail, tail + 1);
+	}
+
+	s_shm.lost = i_ae_atomic_load(&h->dropped);
+
+	I_AE_THREAD_RETURN;
+}
+
+I_AE_THREAD_FUNCTION(socket_main, arg)
+{
+	int fd = (int)(intptr_t)arg;
+	char* datagram = malloc(STRESS_DATAGRAM_SIZE);
+
+	if (!datagram)
+	{
+		I_AE_THREAD_RETURN;
+	}
+
+	for (;;)
+	{
+		ssize_t n = recv(fd, datagram, STRESS_DATAGRAM_SIZE, 0);
+
+		// The receive times out regularly, and once the test is over the queue has been emptied
+		if (n <= 0)
+		{
+			if (i_ae_atomic_load(&s_stopping))
+			{
+				break;
+			}
+
+			continue;
+		}
+
+		const char* end = datagram + n;
+
+		for (const char* line = datagram; line < end;)
+		{
+			const char* next = memchr(line, '\n', (size_t)(end - line));
+			next = next ? next : end;
+
+			uint64_t length;
+			const char* message = line_message(line, next, &length);
+
+			if (message)
+			{
+				tally_add(&s_socket, message, length, UINT64_MAX);
+			}
+
+			else
+			{
+				s_socket.corrupt++;
+			}
+
+			line = next + 1;
+		}
+	}
+
+	free(datagram);
+
+	I_AE_THREAD_RETURN;
+}
+
+// Test ---------------------------------------------------------------------------------------------------------
+
+I_AE_THREAD_FUNCTION(worker_main, arg)
+{
+	worker* w = arg;
+	char text[STRESS_PAYLOAD_MAX];
+	char name[AE_LOG_THREAD_NAME_SIZE];
+
+	sprintf_s(name, sizeof(name), "stress-%u", w->index);
+	AE_LOG_THREAD_NAME_SET(name);
+
+	// Errors go to the priority lane, which may not drop them even though the buffers drop when full
+	log_level level = w->phase == PHASE_PRIORITY ? ERROR : INFO;
+
+	if (w->phase == PHASE_BATCH || (w->phase == PHASE_PRIORITY && w->index % 2 == 1))
+	{
+		for (uint32_t i = 0; i < s_messages; i += STRESS_BATCH)
+		{
+			ae_log_batch* b;
+			AE_LOG_FILE_BATCH_BEGIN(b, level, STRESS_BATCH);
+
+			for (uint32_t j = i; j < i + STRESS_BATCH && j < s_messages; j++)
+			{
+				uint32_t length = payload(text, w->phase, w->index, j);
+				AE_LOG_FILE_BATCH_ADD(b, "stress %u %u %u %08x %.*s", w->phase, w->index, j, checksum(text, length), (int)length, text);
+			}
+
+			AE_LOG_FILE_BATCH_COMMIT(b);
+		}
+
+		I_AE_THREAD_RETURN;
+	}
+
+	for (uint32_t i = 0; i < s_messages; i++)
+	{
+		uint32_t length = payload(text, w->phase, w->index, i);
+		AE_LOG_FILE(level, "stress %u %u %u %08x %.*s", w->phase, w->index, i, checksum(text, length), (int)length, text);
+	}
+
+	I_AE_THREAD_RETURN;
+}
+
+/// <summary>
+/// Logs from every thread in one phase, then exports the log file and reads it back.
+/// </summary>
+static int phase_run(uint32_t phase)
+{
+	worker workers[STRESS_MAX_THREADS];
+
+	if (phase != PHASE_SYNC)
+	{
+		ae_log_async_config config = { s_threads, 1 << 20, 1000, 0, ERROR, 64 << 10, 2000, 50 };
+
+		if (phase == PHASE_PRIORITY)
+		{
+			config.buffer_size = 8 << 10;
+			config.drop_when_full = 1;
+		}
+
+		if (!AE_LOG_FILE_ASYNC_START(&config))
+		{
+			return 0;
+		}
+	}
+
+	uint64_t start = i_ae_time_monotonic();
+
+	for (uint32_t i = 0; i < s_threads; i++)
+	{
+		workers[i].phase = phase;
+		workers[i].index = i;
+
+		if (!i_ae_thread_create(&workers[i].thread, worker_main, &workers[i]))
+		{
+			AE_LOG_CONSOLE_ERROR("Failed to start thread %u.", i);
+			return 0;
+		}
+	}
+
+	for (uint32_t i = 0; i < s_threads; i++)
+	{
+		i_ae_thread_join(workers[i].thread);
+	}
+
+	double seconds = (double)(i_ae_time_monotonic() - start) / 1e9;
+
+	if (phase != PHASE_SYNC)
+	{
+		AE_LOG_FILE_ASYNC_STOP();
+	}
+
+	char path[256];
+	sprintf_s(path, sizeof(path), "/tmp/ae-stress-%d-%s.log", i_ae_process_id(), s_phase_names[phase]);
+
+	AE_LOG_FILE_EXPORT(path);
+
+	uint64_t before = s_file.received;
+	int read = file_check(path);
+
+	remove(path);
+
+	AE_LOG_CONSOLE_INFO("Phase %s: logged %llu messages in %.2f s, %llu found in the log file.", s_phase_names[phase],
+		(unsigned long long)s_threads * s_messages, seconds, (unsigned long long)(s_file.received - before));
+
+	return read;
+}
+
+int main(int argc, char** argv)
+{
+	s_threads = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : s_threads;
+	s_messages = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : s_messages;
+
+	if (s_threads < 1 || s_threads > STRESS_MAX_THREADS || s_messages < 1)
+	{
+		AE_LOG_CONSOLE_ERROR("Usage: StressTest [threads (1-%d)] [messages per thread]", STRESS_MAX_THREADS);
+		return 1;
+	}
+
+	if (!tally_create(&s_file) || !tally_create(&s_subscriber) || !tally_create(&s_shm) || !tally_create(&s_socket))
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to allocate memory for %u threads.", s_threads);
+		return 1;
+	}
+
+	AE_LOG_FILE_LEVEL_SET(TRACE);
+
+	// Subscriber
+	ae_log_cursor* cursor = AE_LOG_SUBSCRIBE();
+	i_ae_thread subscriber;
+
+	if (!cursor || !i_ae_thread_create(&subscriber, subscriber_main, cursor))
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to start the subscriber.");
+		return 1;
+	}
+
+	// Shared memory, the ring is mapped a second time the way the Collector maps it
+	char ring_name[64];
+	sprintf_s(ring_name, sizeof(ring_name), "/stress-%d", i_ae_process_id());
+
+	if (!AE_LOG_SHM_OPEN("stress", STRESS_SHM_SLOTS))
+	{
+		return 1;
+	}
+
+	int ring_fd = shm_open(ring_name, O_RDWR, 0600);
+	void* ring = ring_fd >= 0 ? mmap(NULL, i_ae_shm_size(STRESS_SHM_SLOTS), PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0) : MAP_FAILED;
+
+	if (ring_fd >= 0)
+	{
+		close(ring_fd);
+	}
+
+	i_ae_thread drainer;
+
+	if (ring == MAP_FAILED || !i_ae_thread_create(&drainer, shm_main, ring))
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to map the shared-memory ring %s.", ring_name);
+		return 1;
+	}
+
+	// Socket
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	sprintf_s(address.sun_path, sizeof(address.sun_path), "/tmp/ae-stress-%d.sock", i_ae_process_id());
+
+	unlink(address.sun_path);
+
+	int socket_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	struct timeval timeout = { 0, 100000 };
+	int buffer = 8 << 20;
+
+	i_ae_thread receiver;
+
+	if (socket_fd < 0 || bind(socket_fd, (struct sockaddr*)&address, sizeof(address)) != 0
+		|| setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0
+		|| !i_ae_thread_create(&receiver, socket_main, (void*)(intptr_t)socket_fd))
+	{
+		AE_LOG_CONSOLE_ERROR("Failed to bind the socket %s.", address.sun_path);
+		return 1;
+	}
+
+	// A larger receive buffer only makes drops less likely
+	setsockopt(socket_fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+
+	if (!AE_LOG_SOCKET_OPEN(address.sun_path, AE_LOG_SOCKET_PLAIN))
+	{
+		return 1;
+	}
+
+	AE_LOG_CONSOLE_INFO("Logging %u messages from each of %u threads in %d phases.", s_messages, s_threads, PHASE_COUNT);
+
+	int passed = 1;
+
+	for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+	{
+		passed = phase_run(phase) && passed;
+	}
+
+	// Every sink is drained before the readers are stopped
+	AE_LOG_SOCKET_CLOSE();
+	i_ae_atomic_store(&s_stopping, 1);
+
+	i_ae_thread_join(subscriber);
+	i_ae_thread_join(drainer);
+	i_ae_thread_join(receiver);
+
+	AE_LOG_UNSUBSCRIBE(cursor);
+	AE_LOG_SHM_CLOSE();
+
+	munmap(ring, i_ae_shm_size(STRESS_SHM_SLOTS));
+	shm_unlink(ring_name);
+
+	close(socket_fd);
+	unlink(address.sun_path);
+
+	// The socket counts what it dropped on its own, so losses that were not counted fail the test
+	ae_log_stats stats;
+	AE_LOG_STATS_GET(&stats);
+
+	s_socket.lost = stats.socket_dropped;
+
+	passed = tally_report(&s_file, 1, 0) && passed;
+	passed = tally_report(&s_subscriber, 0, 1) && passed;
+	passed = tally_report(&s_shm, 0, 1) && passed;
+	passed = tally_report(&s_socket, 0, 1) && passed;
+
+	tally_destroy(&s_file);
+	tally_destroy(&s_subscriber);
+	tally_destroy(&s_shm);
+	tally_destroy(&s_socket);
+
+	if (!passed)
+	{
+		AE_LOG_CONSOLE_FATAL("Records were lost, damaged or reordered.");
+		return 1;
+	}
+
+	AE_LOG_CONSOLE_INFO("Every record was delivered intact.");
+	return 0;
+}
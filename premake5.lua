@@ -1,7 +1,7 @@
 
 workspace "AerideusLog"
     architecture "x64"
-    configurations { "Debug", "Release", "Dist" }
+    configurations { "Debug", "Release", "Dist", "ASan", "TSan" }
 
     filter "system:windows"
         defines { "AE_WINDOWS" }
@@ -25,6 +25,23 @@ workspace "AerideusLog"
         optimize "Speed"
         symbols "Off"
 
+    -- Debug builds instrumented with AddressSanitizer and ThreadSanitizer, used to run the StressTest project
+    filter "configurations:ASan or TSan"
+        defines { "AE_DEBUG", "AE_SANITIZE" }
+        symbols "On"
+
+    filter { "configurations:ASan", "system:windows" }
+        sanitize { "Address" }
+
+    filter { "configurations:ASan", "not system:windows" }
+        buildoptions { "-fsanitize=address", "-fno-omit-frame-pointer" }
+        linkoptions { "-fsanitize=address" }
+
+    -- ThreadSanitizer is not available with MSVC, so TSan is a plain debug build on Windows
+    filter { "configurations:TSan", "not system:windows" }
+        buildoptions { "-fsanitize=thread" }
+        linkoptions { "-fsanitize=thread" }
+
     filter "action:vs*"
         startproject "Sandbox"
 
@@ -48,3 +65,90 @@ project "Sandbox"
     includedirs { "AerideusLog/include" }
 
     links { "AerideusLog" }
+
+    filter "system:linux"
+        links { "rt", "pthread" }
+
+-- The Collector drains POSIX shared-memory rings and is not built on Windows
+if os.target() ~= "windows" then
+
+project "Collector"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    targetdir "bin/%{cfg.buildcfg}"
+    objdir "obj/%{cfg.buildcfg}"
+
+    files { "Collector/src/*.c", "Collector/src/*.h" }
+    includedirs { "AerideusLog/include", "AerideusLog/internal" }
+
+    links { "AerideusLog" }
+
+    filter "system:linux"
+        links { "rt", "pthread" }
+
+-- Replaces malloc and free to check that logging does not allocate memory after setup
+project "AllocTest"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    targetdir "bin/%{cfg.buildcfg}"
+    objdir "obj/%{cfg.buildcfg}"
+
+    files { "AllocTest/src/*.c", "AllocTest/src/*.h" }
+    includedirs { "AerideusLog/include" }
+
+    links { "AerideusLog" }
+
+    filter "system:linux"
+        links { "rt", "pthread" }
+
+-- Merges log files by time through memory maps
+project "Merge"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    targetdir "bin/%{cfg.buildcfg}"
+    objdir "obj/%{cfg.buildcfg}"
+
+    files { "Merge/src/*.c", "Merge/src/*.h" }
+    includedirs { "AerideusLog/include", "AerideusLog/internal" }
+
+    links { "AerideusLog" }
+
+    filter "system:linux"
+        links { "rt", "pthread" }
+
+-- Drives the logging macros with the load of a profile and reports throughput, call time and sink lag
+project "LoadGen"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    targetdir "bin/%{cfg.buildcfg}"
+    objdir "obj/%{cfg.buildcfg}"
+
+    files { "LoadGen/src/*.c", "LoadGen/src/*.h" }
+    includedirs { "AerideusLog/include", "AerideusLog/internal" }
+
+    links { "AerideusLog" }
+
+    filter "system:linux"
+        links { "rt", "pthread" }
+
+-- Logs checksummed messages from many threads through every sink and checks that none are lost, torn or reordered
+project "StressTest"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    targetdir "bin/%{cfg.buildcfg}"
+    objdir "obj/%{cfg.buildcfg}"
+
+    files { "StressTest/src/*.c", "StressTest/src/*.h" }
+    includedirs { "AerideusLog/include", "AerideusLog/internal" }
+
+    links { "AerideusLog" }
+
+    filter "system:linux"
+        links { "rt", "pthread" }
+
+end